@@ -5,17 +5,28 @@
 #include <string>
 #include <sstream>
 
+#include "search/options.h"
+
 namespace Args {
 
 template <typename Game>
 struct Args
 {
     bool telnet{false};
+    bool uci{false};
+    // The host and port of the server to connect to, or empty to play the
+    // telnet game through stdin and stdout.
+    std::string host;
+    std::string port;
     std::string gameId;
     int player{0};
     int timeLimitInMs{20000};
+    // The time for all the moves of a player in a game, or 0 for none.
+    int budgetInMs{0};
     typename Game::StateType initialState;
+    Search::Options options;
     bool debug{false};
+    std::string logFile;
     bool help{false};
 };
 
@@ -37,6 +48,18 @@ private:
     std::string message;
 };
 
+// Parses the number following a parameter, such as 100 in -t100.
+template <typename T>
+T parseNumber(const std::string& arg)
+{
+    T value;
+    std::stringstream ss{arg.substr(2)};
+    ss >> value;
+    if (!ss || !ss.eof())
+        throw ArgsError{"invalid argument: " + arg};
+    return value;
+}
+
 template <typename Game>
 typename Game::StateType getState(const std::string& file);
 
@@ -59,6 +82,23 @@ Args<Game> parse(int argc, char** argv)
                 args.telnet = true;
                 break;
             }
+            case 's':
+            {
+                auto address = arg.substr(2);
+                auto colon = address.rfind(':');
+                if (colon == std::string::npos || colon == 0 ||
+                    colon + 1 == address.length())
+                    throw ArgsError{"invalid server address: " + address};
+                args.telnet = true;
+                args.host = address.substr(0, colon);
+                args.port = address.substr(colon + 1);
+                break;
+            }
+            case 'u':
+            {
+                args.uci = true;
+                break;
+            }
             case 'i':
             {
                 args.gameId = arg.substr(2);
@@ -67,22 +107,27 @@ Args<Game> parse(int argc, char** argv)
             case 'p':
             case 'h':
             {
-                int player;
-                std::stringstream ss{arg.substr(2)};
-                ss >> player;
-                if (!ss)
-                    throw ArgsError{"invalid argument: " + arg};
-                args.player = player;
+                args.player = parseNumber<int>(arg);
                 break;
             }
             case 't':
             {
-                int timeLimitInMs;
-                std::stringstream ss{arg.substr(2)};
-                ss >> timeLimitInMs;
-                if (!ss)
-                    throw ArgsError{"invalid argument: " + arg};
-                args.timeLimitInMs = timeLimitInMs;
+                args.timeLimitInMs = parseNumber<int>(arg);
+                break;
+            }
+            case 'b':
+            {
+                args.budgetInMs = parseNumber<int>(arg);
+                break;
+            }
+            case 'j':
+            {
+                args.options.threads = parseNumber<int>(arg);
+                break;
+            }
+            case 'm':
+            {
+                args.options.hashSizeInMb = parseNumber<int>(arg);
                 break;
             }
             case 'f':
@@ -96,6 +141,13 @@ Args<Game> parse(int argc, char** argv)
                 args.debug = true;
                 break;
             }
+            case 'l':
+            {
+                args.logFile = arg.substr(2);
+                if (args.logFile.empty())
+                    throw ArgsError{"invalid argument: " + arg};
+                break;
+            }
             case 'H':
             {
                 args.help = true;
@@ -139,6 +191,21 @@ void validate(const Args<Game>& args)
         throw ArgsError{"cannot play with negative time: " +
                         std::to_string(args.timeLimitInMs)};
 
+    if (args.budgetInMs < 0)
+        throw ArgsError{"cannot play with a negative budget: " +
+                        std::to_string(args.budgetInMs)};
+
+    if (args.options.threads < 1)
+        throw ArgsError{"invalid number of threads: " +
+                        std::to_string(args.options.threads)};
+
+    if (args.options.hashSizeInMb < 1)
+        throw ArgsError{"invalid transposition table size: " +
+                        std::to_string(args.options.hashSizeInMb)};
+
+    if (args.telnet && args.uci)
+        throw ArgsError{"cannot play both the telnet and engine protocols"};
+
     if (args.telnet)
     {
         if (args.gameId.empty())
@@ -159,14 +226,29 @@ void printUsage(const std::string& progname)
     Args<Game> args;
     std::cerr
         << std::boolalpha << "Usage: " << progname
-        << " [-n -i<id> -p<player>] [-t<ms>] [-d] [-H]" << std::endl
+        << " [-n | -s<address>] -i<id> -p<player> [-t<ms>] [-b<ms>]"
+        << " [-j<threads>] [-m<MB>] [-d] [-l<filename>] [-H]" << std::endl
         << "       " << progname
-        << " [-h<player>] [-f<filename>] [-t<ms>] [-d] [-H]" << std::endl
+        << " [-h<player>] [-f<filename>] [-t<ms>] [-b<ms>] [-j<threads>]"
+        << " [-m<MB>] [-d] [-l<filename>] [-H]" << std::endl
+        << "       " << progname
+        << " -u [-j<threads>] [-m<MB>] [-d] [-l<filename>] [-H]" << std::endl
         << std::endl
         << "    -n:           "
            "Play the game using the telnet protocol through stdin "
            "and stdout. Defaults to "
         << args.telnet << "." << std::endl
+        << "    -s<address>:  "
+           "Play the game using the telnet protocol through a TCP connection "
+           "to the server"
+        << std::endl
+        << "                  "
+           "at <address> = <host>:<port>."
+        << std::endl
+        << "    -u:           "
+           "Play the game using a UCI-style engine protocol through stdin "
+           "and stdout."
+        << std::endl
         << "    -i<id>:       "
            "Specifies the id to use for the telnet game. <id> must not contain "
            "whitespace."
@@ -190,9 +272,26 @@ void printUsage(const std::string& progname)
         << "    -t<ms>:       "
            "Play with the specified time limit in ms. Defaults to "
         << args.timeLimitInMs << " ms." << std::endl
+        << "    -b<ms>:       "
+           "Divide the specified time in ms between the moves of each "
+           "player, with"
+        << std::endl
+        << "                  "
+           "at most the time limit per move. Defaults to no budget."
+        << std::endl
+        << "    -j<threads>:  "
+           "Search with the specified number of threads. Defaults to "
+        << args.options.threads << "." << std::endl
+        << "    -m<MB>:       "
+           "Limit the transposition table to the specified size in MB. "
+           "Defaults to "
+        << args.options.hashSizeInMb << " MB." << std::endl
         << "    -d:           "
            "Play with additional debug information. Defaults to "
         << args.debug << "." << std::endl
+        << "    -l<filename>: "
+           "Append the debug information to the given file as well."
+        << std::endl
         << "    -H:           "
            "Print usage information."
         << std::endl;
@@ -0,0 +1,127 @@
+#include "connection.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace {
+
+std::runtime_error systemError(const std::string& message)
+{
+    return std::runtime_error{message + ": " + std::strerror(errno)};
+}
+}
+
+void StreamConnection::send(const std::string& line)
+{
+    std::cout << line << std::endl;
+}
+
+bool StreamConnection::receive(std::string& line)
+{
+    if (!std::getline(std::cin, line))
+        return false;
+    if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+    return true;
+}
+
+SocketConnection::SocketConnection(
+    const std::string& host, const std::string& port)
+{
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    auto status = getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+    if (status != 0)
+        throw std::runtime_error{"cannot find server " + host + ": " +
+                                 gai_strerror(status)};
+
+    // Try each address of the server until one of them accepts.
+    for (auto address = addresses; address; address = address->ai_next)
+    {
+        socket = ::socket(
+            address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (socket == -1)
+            continue;
+        if (connect(socket, address->ai_addr, address->ai_addrlen) == 0)
+            break;
+        close(socket);
+        socket = -1;
+    }
+    freeaddrinfo(addresses);
+    if (socket == -1)
+        throw systemError("cannot connect to " + host + ":" + port);
+
+    int flag = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK);
+}
+
+SocketConnection::~SocketConnection()
+{
+    close(socket);
+}
+
+void SocketConnection::send(const std::string& line)
+{
+    auto data = line + "\n";
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+        auto count = ::send(
+            socket, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (count >= 0)
+            sent += count;
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            wait(POLLOUT);
+        else if (errno != EINTR)
+            throw systemError("cannot send to server");
+    }
+}
+
+bool SocketConnection::receive(std::string& line)
+{
+    while (true)
+    {
+        auto end = buffer.find('\n');
+        if (end != std::string::npos)
+        {
+            line = buffer.substr(0, end);
+            buffer.erase(0, end + 1);
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            return true;
+        }
+
+        char data[4096];
+        auto count = recv(socket, data, sizeof(data), 0);
+        if (count > 0)
+            buffer.append(data, count);
+        else if (count == 0)
+            return false;
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            wait(POLLIN);
+        else if (errno != EINTR)
+            throw systemError("cannot receive from server");
+    }
+}
+
+void SocketConnection::wait(short events)
+{
+    pollfd descriptor{socket, events, 0};
+    while (poll(&descriptor, 1, -1) == -1)
+        if (errno != EINTR)
+            throw systemError("cannot wait for server");
+}
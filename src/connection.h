@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+
+// A line-oriented connection to a game server.
+class Connection
+{
+public:
+    virtual ~Connection() = default;
+
+    // Sends a line, to which the line ending is added.
+    virtual void send(const std::string& line) = 0;
+
+    // Receives the next line, without its line ending. This returns false
+    // once the connection is closed.
+    virtual bool receive(std::string& line) = 0;
+};
+
+// A connection through standard input and output, such as when a pipeline of
+// other programs connects the agent to the server.
+class StreamConnection : public Connection
+{
+public:
+    virtual void send(const std::string& line) override;
+    virtual bool receive(std::string& line) override;
+};
+
+// A TCP connection to the server. The socket does not block, and is waited on
+// with poll(), and Nagle's algorithm is turned off, since every line is a
+// move to be sent right away.
+class SocketConnection : public Connection
+{
+public:
+    SocketConnection(const std::string& host, const std::string& port);
+    virtual ~SocketConnection();
+
+    SocketConnection(const SocketConnection&) = delete;
+    SocketConnection& operator=(const SocketConnection&) = delete;
+
+    virtual void send(const std::string& line) override;
+    virtual bool receive(std::string& line) override;
+
+private:
+    int socket{-1};
+    // The data received that does not make a full line yet.
+    std::string buffer;
+
+    void wait(short events);
+};
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <stdexcept>
+
+#include "game/definition.h"
+#include "game/point.h"
+#include "game/game.h"
+#include "game/bitboard-state.h"
+
+namespace DynamicConnect4 {
+
+// An implementation of the game on top of BitboardState. Moves are generated
+// with masked shifts, applied with XOR updates, and four in a row is detected
+// with chains of shifts and ANDs. The methods are defined inline since they are
+// called at every node of the search.
+class BitboardGame
+{
+public:
+    using StateType = BitboardState;
+    using ActionType = Game::ActionType;
+    using EvalType = Game::EvalType;
+    using ActionListType = Game::ActionListType;
+
+    static const int actionCodeCount = Game::actionCodeCount;
+
+    static int getActionCode(const ActionType& action)
+    {
+        return Game::getActionCode(action);
+    }
+
+    static ActionType getAction(int code)
+    {
+        return Game::getAction(code);
+    }
+
+    ActionListType getActions(const StateType& state) const
+    {
+        using namespace Bitboard;
+
+        auto empty = boardMask & ~(state.whitePieces | state.blackPieces);
+
+        ActionListType result;
+        auto pieces = state.isPlayerOne ? state.whitePieces : state.blackPieces;
+        while (pieces)
+        {
+            auto index = lowestIndex(pieces);
+            auto piece = uint64_t{1} << index;
+            auto point = toPoint(index);
+            if ((piece << xStep) & empty)
+                result.emplace_back(point, Direction::east);
+            if ((piece >> xStep) & empty)
+                result.emplace_back(point, Direction::west);
+            if ((piece << yStep) & empty)
+                result.emplace_back(point, Direction::south);
+            if ((piece >> yStep) & empty)
+                result.emplace_back(point, Direction::north);
+            pieces &= pieces - 1;
+        }
+        return result;
+    }
+
+    bool isLegal(const StateType& state, const ActionType& action) const
+    {
+        using namespace Bitboard;
+
+        auto empty = boardMask & ~(state.whitePieces | state.blackPieces);
+        auto pieces = state.isPlayerOne ? state.whitePieces : state.blackPieces;
+        auto piece = toMask(action.first);
+        if (!(pieces & piece))
+            return false;
+
+        switch (action.second)
+        {
+        case Direction::east:
+            return (piece << xStep) & empty;
+        case Direction::west:
+            return (piece >> xStep) & empty;
+        case Direction::south:
+            return (piece << yStep) & empty;
+        case Direction::north:
+            return (piece >> yStep) & empty;
+        default:
+            return false;
+        }
+    }
+
+    StateType getResult(StateType state, const ActionType& action) const
+    {
+        makeMove(state, action);
+        return state;
+    }
+
+    void makeMove(StateType& state, const ActionType& action) const
+    {
+        toggleMove(state, action);
+        state.isPlayerOne = !state.isPlayerOne;
+    }
+
+    void unmakeMove(StateType& state, const ActionType& action) const
+    {
+        // The XOR update is its own inverse.
+        state.isPlayerOne = !state.isPlayerOne;
+        toggleMove(state, action);
+    }
+
+    bool isTerminal(const StateType& state) const
+    {
+        using namespace Bitboard;
+
+        // If it is the current player's turn,
+        // then the other player is the one who may have won.
+        auto pieces = state.isPlayerOne ? state.blackPieces : state.whitePieces;
+        for (auto step : {antidiagonalStep, xStep, diagonalStep, yStep})
+        {
+            // The pairs of pieces one step apart, then the pairs of pairs.
+            auto pairs = pieces & (pieces >> step);
+            if (pairs & (pairs >> (2 * step)))
+                return true;
+        }
+        return false;
+    }
+
+    EvalType getUtility(const StateType& state) const
+    {
+        // Assume the state is terminal. If it is the current player's turn,
+        // then the other player is the winner.
+        return state.isPlayerOne ? std::numeric_limits<EvalType>::lowest() :
+                                   std::numeric_limits<EvalType>::max();
+    }
+
+    bool isRepetition(
+        const StateType& state, const std::vector<StateType>& history) const
+    {
+        return isRepeated(state, history);
+    }
+
+    static EvalType getDrawUtility()
+    {
+        return Game::getDrawUtility();
+    }
+
+private:
+    // Moves the piece of an action for the player to move, or moves it back,
+    // and updates the key for the move and the change of turn.
+    void toggleMove(StateType& state, const ActionType& action) const
+    {
+        auto from = Bitboard::toIndex(action.first);
+        auto to = from + getStep(action.second);
+        auto player = state.isPlayerOne ? 0 : 1;
+        auto& pieces =
+            state.isPlayerOne ? state.whitePieces : state.blackPieces;
+        pieces ^= (uint64_t{1} << from) | (uint64_t{1} << to);
+        state.key ^= Zobrist::keys.pieces[player][from] ^
+            Zobrist::keys.pieces[player][to] ^ Zobrist::keys.playerTwo;
+    }
+
+    int getStep(Direction direction) const
+    {
+        using namespace Bitboard;
+
+        switch (direction)
+        {
+        case Direction::east:
+            return xStep;
+        case Direction::west:
+            return -xStep;
+        case Direction::south:
+            return yStep;
+        case Direction::north:
+            return -yStep;
+        default:
+            throw std::logic_error{"impossible"};
+        }
+    }
+};
+}
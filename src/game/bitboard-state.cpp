@@ -0,0 +1,71 @@
+#include "game/bitboard-state.h"
+
+#include <iostream>
+
+namespace DynamicConnect4 {
+
+BitboardState::BitboardState(const State& state)
+    : isPlayerOne{state.isPlayerOne}
+{
+    for (const auto& piece : state.whitePieces)
+        whitePieces |= Bitboard::toMask(piece);
+    for (const auto& piece : state.blackPieces)
+        blackPieces |= Bitboard::toMask(piece);
+    key = computeKey();
+}
+
+State BitboardState::toState() const
+{
+    // Extracting the pieces from the lowest bit up keeps them sorted.
+    State state;
+    state.isPlayerOne = isPlayerOne;
+    auto pieces = whitePieces;
+    for (auto& piece : state.whitePieces)
+    {
+        piece = Bitboard::toPoint(Bitboard::lowestIndex(pieces));
+        pieces &= pieces - 1;
+    }
+    pieces = blackPieces;
+    for (auto& piece : state.blackPieces)
+    {
+        piece = Bitboard::toPoint(Bitboard::lowestIndex(pieces));
+        pieces &= pieces - 1;
+    }
+    return state;
+}
+
+uint64_t BitboardState::computeKey() const
+{
+    uint64_t result = isPlayerOne ? 0 : Zobrist::keys.playerTwo;
+    for (auto pieces = whitePieces; pieces; pieces &= pieces - 1)
+        result ^= Zobrist::keys.pieces[0][Bitboard::lowestIndex(pieces)];
+    for (auto pieces = blackPieces; pieces; pieces &= pieces - 1)
+        result ^= Zobrist::keys.pieces[1][Bitboard::lowestIndex(pieces)];
+    return result;
+}
+
+bool operator==(const BitboardState& lhs, const BitboardState& rhs)
+{
+    return lhs.isPlayerOne == rhs.isPlayerOne &&
+        lhs.whitePieces == rhs.whitePieces &&
+        lhs.blackPieces == rhs.blackPieces;
+}
+
+bool operator!=(const BitboardState& lhs, const BitboardState& rhs)
+{
+    return !(lhs == rhs);
+}
+
+std::istream& operator>>(std::istream& in, BitboardState& state)
+{
+    State result;
+    if (in >> result)
+        state = BitboardState{result};
+    return in;
+}
+
+std::ostream& operator<<(std::ostream& out, const BitboardState& state)
+{
+    return out << state.toState();
+}
+}
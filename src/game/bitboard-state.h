@@ -0,0 +1,108 @@
+#pragma once
+
+#include <iosfwd>
+#include <functional>
+#include <cstdint>
+
+#include "game/definition.h"
+#include "game/point.h"
+#include "game/state.h"
+#include "game/zobrist.h"
+
+namespace DynamicConnect4 {
+
+// Helpers for working with 64 bit occupancy masks of the board. The square
+// (x, y) is stored at bit 8 * x + y, so every column takes up one byte. The
+// eighth bit of each column and the eighth byte are never used, which makes
+// them a guard: shifting a mask by one step in any direction either lands on
+// a valid square or on a guard bit, never on the wrong side of the board.
+namespace Bitboard {
+
+static const uint64_t boardMask = 0x007F7F7F7F7F7F7Full;
+
+// The shift amounts for one step in each direction. A step towards higher x
+// or y is a left shift, and a step towards lower x or y is a right shift.
+static const int xStep = 8;
+static const int yStep = 1;
+static const int diagonalStep = xStep + yStep;
+static const int antidiagonalStep = xStep - yStep;
+
+inline int toIndex(Point point)
+{
+    return 8 * point.x() + point.y();
+}
+
+inline uint64_t toMask(Point point)
+{
+    return uint64_t{1} << toIndex(point);
+}
+
+inline Point toPoint(int index)
+{
+    return Point{index >> 3, index & 7};
+}
+
+inline int popcount(uint64_t mask)
+{
+    return __builtin_popcountll(mask);
+}
+
+inline int lowestIndex(uint64_t mask)
+{
+    return __builtin_ctzll(mask);
+}
+
+// Counts the pairs of pieces on a line along the given step with no gap between
+// them, so that a set of N pieces in a row contributes N*(N-1)/2 pairs.
+inline int countConnectedPairs(uint64_t pieces, int step)
+{
+    // After k iterations, a bit is left in the run for every piece followed by
+    // k more pieces along the step.
+    int result = 0;
+    for (auto run = pieces & (pieces >> step); run; run &= run >> step)
+        result += popcount(run);
+    return result;
+}
+}
+
+// A bitboard representation of the state, which stores one occupancy mask per
+// player. Unlike State, it needs no sorting or scratch board to be worked with,
+// which makes it the faster choice for searching. It also carries the Zobrist
+// key of the position, which must be kept up to date along with the masks.
+struct BitboardState
+{
+    bool isPlayerOne{true};
+    uint64_t whitePieces{};
+    uint64_t blackPieces{};
+    uint64_t key{};
+
+    BitboardState() : BitboardState{State{}}
+    {
+    }
+
+    explicit BitboardState(const State& state);
+
+    State toState() const;
+
+    // Computes the Zobrist key of the position from scratch.
+    uint64_t computeKey() const;
+};
+
+bool operator==(const BitboardState& lhs, const BitboardState& rhs);
+bool operator!=(const BitboardState& lhs, const BitboardState& rhs);
+
+std::istream& operator>>(std::istream& in, BitboardState& state);
+std::ostream& operator<<(std::ostream& out, const BitboardState& state);
+}
+
+namespace std {
+template <>
+struct hash<DynamicConnect4::BitboardState>
+{
+    size_t operator()(const DynamicConnect4::BitboardState& state) const
+    {
+        // The Zobrist key is maintained incrementally, so hashing is free.
+        return state.key;
+    }
+};
+}
@@ -6,6 +6,7 @@ namespace DynamicConnect4 {
 
 static const int boardSize = 7;
 static const int piecesPerPlayer = 6;
+static const int maxActions = 4 * piecesPerPlayer;
 
 enum class Direction : int8_t
 {
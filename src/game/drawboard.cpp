@@ -1,5 +0,0 @@
-#include "game/drawboard.h"
-
-namespace DynamicConnect4 {
-std::array<std::array<int8_t, boardSize>, boardSize> Drawboard::drawboard{0};
-}
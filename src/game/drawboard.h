@@ -9,13 +9,13 @@
 
 namespace DynamicConnect4 {
 
-// A small static array representing the game board to use as scratch paper when
-// computing things. The constructor and destructor fill and erase the array, so
-// care must be taken to avoid multiple simultaneous instantiations.
+// A small array representing the game board to use as scratch paper when
+// computing things. Every instance owns its board, so any number of them may
+// be alive at once, including on different threads.
 class Drawboard
 {
 public:
-    Drawboard(State state) : state{state}
+    Drawboard(const State& state)
     {
         for (const auto& piece : state.whitePieces)
             drawboard[piece.x()][piece.y()] = 1;
@@ -23,14 +23,6 @@ public:
             drawboard[piece.x()][piece.y()] = 2;
     }
 
-    ~Drawboard()
-    {
-        for (const auto& piece : state.whitePieces)
-            drawboard[piece.x()][piece.y()] = 0;
-        for (const auto& piece : state.blackPieces)
-            drawboard[piece.x()][piece.y()] = 0;
-    }
-
     int8_t get(int x, int y) const
     {
         if (x < 0 || x >= boardSize || y < 0 || y >= boardSize)
@@ -39,8 +31,6 @@ public:
     }
 
 private:
-    static std::array<std::array<int8_t, boardSize>, boardSize> drawboard;
-
-    State state;
+    std::array<std::array<int8_t, boardSize>, boardSize> drawboard{};
 };
 }
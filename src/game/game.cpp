@@ -11,12 +11,13 @@ namespace DynamicConnect4 {
 using StateType = Game::StateType;
 using ActionType = Game::ActionType;
 using EvalType = Game::EvalType;
+using ActionListType = Game::ActionListType;
 
-std::vector<ActionType> Game::getActions(const StateType& state) const
+ActionListType Game::getActions(const StateType& state) const
 {
     Drawboard board{state};
 
-    std::vector<ActionType> result;
+    ActionListType result;
     auto& pieces = state.isPlayerOne ? state.whitePieces : state.blackPieces;
     for (const auto& piece : pieces)
     {
@@ -34,7 +35,20 @@ std::vector<ActionType> Game::getActions(const StateType& state) const
     return result;
 }
 
+bool Game::isLegal(const StateType& state, const ActionType& action) const
+{
+    auto actions = getActions(state);
+    return std::find(std::begin(actions), std::end(actions), action) !=
+        std::end(actions);
+}
+
 StateType Game::getResult(StateType state, const ActionType& action) const
+{
+    makeMove(state, action);
+    return state;
+}
+
+void Game::makeMove(StateType& state, const ActionType& action) const
 {
     auto x = action.first.x();
     auto y = action.first.y();
@@ -63,7 +77,41 @@ StateType Game::getResult(StateType state, const ActionType& action) const
     // Very important to sort after insertion.
     std::sort(std::begin(pieces), std::end(pieces));
     state.isPlayerOne = !state.isPlayerOne;
-    return state;
+}
+
+void Game::unmakeMove(StateType& state, const ActionType& action) const
+{
+    state.isPlayerOne = !state.isPlayerOne;
+
+    auto x = action.first.x();
+    auto y = action.first.y();
+    auto direction = action.second;
+
+    Point destination;
+    switch (direction)
+    {
+    case Direction::east:
+        destination.set(x + 1, y);
+        break;
+    case Direction::west:
+        destination.set(x - 1, y);
+        break;
+    case Direction::south:
+        destination.set(x, y + 1);
+        break;
+    case Direction::north:
+        destination.set(x, y - 1);
+        break;
+    default:
+        throw std::logic_error{"impossible"};
+    }
+
+    auto& pieces = state.isPlayerOne ? state.whitePieces : state.blackPieces;
+    auto it =
+        std::lower_bound(std::begin(pieces), std::end(pieces), destination);
+    it->set(x, y);
+    // Very important to sort after insertion.
+    std::sort(std::begin(pieces), std::end(pieces));
 }
 
 bool Game::isTerminal(const StateType& state) const
@@ -108,6 +156,12 @@ EvalType Game::getUtility(const StateType& state) const
                                std::numeric_limits<EvalType>::max();
 }
 
+bool Game::isRepetition(
+    const StateType& state, const std::vector<StateType>& history) const
+{
+    return isRepeated(state, history);
+}
+
 std::istream& operator>>(std::istream& in, ActionType& action)
 {
     char xc, yc, dirc;
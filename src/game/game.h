@@ -1,12 +1,14 @@
 #pragma once
 
-#include <vector>
 #include <utility>
+#include <vector>
+#include <algorithm>
 #include <iosfwd>
 
 #include "game/definition.h"
 #include "game/point.h"
 #include "game/state.h"
+#include "util/static-vector.h"
 
 namespace DynamicConnect4 {
 
@@ -16,13 +18,60 @@ public:
     using StateType = State;
     using ActionType = std::pair<Point, Direction>;
     using EvalType = float;
+    using ActionListType = Util::StaticVector<ActionType, maxActions>;
+
+    // Every action has a code in [0, actionCodeCount), for use as a compact
+    // representation or as an index into tables.
+    static const int actionCodeCount = 4 * boardSize * boardSize;
+    static int getActionCode(const ActionType& action);
+    static ActionType getAction(int code);
 
-    std::vector<ActionType> getActions(const StateType& state) const;
+    ActionListType getActions(const StateType& state) const;
+    bool isLegal(const StateType& state, const ActionType& action) const;
     StateType getResult(StateType state, const ActionType& action) const;
+    void makeMove(StateType& state, const ActionType& action) const;
+    void unmakeMove(StateType& state, const ActionType& action) const;
     bool isTerminal(const StateType& state) const;
     EvalType getUtility(const StateType& state) const;
+
+    // The game is drawn when a position occurs again, since the players could
+    // then keep repeating it. The history holds the earlier positions of the
+    // game.
+    bool isRepetition(
+        const StateType& state, const std::vector<StateType>& history) const;
+    static EvalType getDrawUtility();
 };
 
+// The helpers below do not depend on the representation of the state, so
+// BitboardGame uses them too. They are inline since the search calls them at
+// every node.
+
+inline int Game::getActionCode(const ActionType& action)
+{
+    auto position = action.first.x() * boardSize + action.first.y();
+    return 4 * position + static_cast<int>(action.second);
+}
+
+inline Game::ActionType Game::getAction(int code)
+{
+    auto position = code / 4;
+    return ActionType{Point{position / boardSize, position % boardSize},
+                      static_cast<Direction>(code % 4)};
+}
+
+inline Game::EvalType Game::getDrawUtility()
+{
+    return 0;
+}
+
+// Checks if a state occurred before in a history of states of any type.
+template <typename StateType>
+bool isRepeated(const StateType& state, const std::vector<StateType>& history)
+{
+    return std::find(std::begin(history), std::end(history), state) !=
+        std::end(history);
+}
+
 std::istream& operator>>(std::istream& in, Game::ActionType& action);
 std::ostream& operator<<(std::ostream& out, const Game::ActionType& action);
 }
@@ -6,10 +6,10 @@
 
 namespace DynamicConnect4 {
 
-using StateType = Game::StateType;
 using EvalType = Game::EvalType;
 
-// A template for combining different heuristics with weights.
+// A template for combining different heuristics with weights. The combined
+// heuristic accepts any state type supported by all of its parts.
 template <typename T, typename... Args>
 class Heuristic
 {
@@ -20,7 +20,8 @@ public:
     {
     }
 
-    EvalType operator()(const StateType& state) const
+    template <typename GameState>
+    EvalType operator()(const GameState& state) const
     {
         return weight * first(state) + others(state);
     }
@@ -40,7 +41,8 @@ public:
     {
     }
 
-    EvalType operator()(const StateType& state) const
+    template <typename GameState>
+    EvalType operator()(const GameState& state) const
     {
         return weight * heuristic(state);
     }
@@ -3,10 +3,10 @@
 #include <array>
 
 #include "game/game.h"
+#include "game/bitboard-state.h"
 
 namespace DynamicConnect4 {
 
-using StateType = Game::StateType;
 using EvalType = Game::EvalType;
 
 // A measure of a player's domination of the center of the board.
@@ -15,13 +15,36 @@ using EvalType = Game::EvalType;
 class CentralDominanceV1
 {
 public:
-    EvalType operator()(const StateType& state) const
+    EvalType operator()(const State& state) const
     {
         return eval(1, state) - eval(2, state);
     }
 
+    EvalType operator()(const BitboardState& state) const
+    {
+        return eval(state.whitePieces) - eval(state.blackPieces);
+    }
+
 private:
-    EvalType eval(int player, const StateType& state) const
+    EvalType eval(int player, const State& state) const
+    {
+        EvalType result = 0;
+        auto& pieces = player == 1 ? state.whitePieces : state.blackPieces;
+        for (const auto& piece : pieces)
+            result += getValue(piece);
+        return result;
+    }
+
+    EvalType eval(uint64_t pieces) const
+    {
+        EvalType result = 0;
+        for (; pieces; pieces &= pieces - 1)
+            result +=
+                getValue(Bitboard::toPoint(Bitboard::lowestIndex(pieces)));
+        return result;
+    }
+
+    EvalType getValue(Point piece) const
     {
         static const std::array<std::array<EvalType, boardSize>, boardSize>
             lookupTable{{
@@ -33,12 +56,7 @@ private:
                 {0.0000f, 0.8125f, 1.0000f, 1.1875f, 1.0000f, 0.8125f, 0.0000f},
                 {0.0000f, 0.0000f, 0.0000f, 0.0000f, 0.0000f, 0.0000f, 0.0000f},
             }};
-
-        EvalType result = 0;
-        auto& pieces = player == 1 ? state.whitePieces : state.blackPieces;
-        for (const auto& piece : pieces)
-            result += lookupTable[piece.x()][piece.y()];
-        return result;
+        return lookupTable[piece.x()][piece.y()];
     }
 };
 
@@ -50,13 +68,48 @@ private:
 class CentralDominanceV2
 {
 public:
-    EvalType operator()(const StateType& state) const
+    EvalType operator()(const State& state) const
     {
         return eval(1, state) - eval(2, state);
     }
 
+    EvalType operator()(const BitboardState& state) const
+    {
+        return eval(state.whitePieces) - eval(state.blackPieces);
+    }
+
 private:
-    EvalType eval(int player, const StateType& state) const
+    EvalType eval(int player, const State& state) const
+    {
+        EvalType result = 0;
+        int count = 0;
+        auto& pieces = player == 1 ? state.whitePieces : state.blackPieces;
+        for (const auto& piece : pieces)
+        {
+            auto value = getValue(piece);
+            result += value;
+            if (value > 0)
+                ++count;
+        }
+        return applyBonus(result, count);
+    }
+
+    EvalType eval(uint64_t pieces) const
+    {
+        EvalType result = 0;
+        int count = 0;
+        for (; pieces; pieces &= pieces - 1)
+        {
+            auto value =
+                getValue(Bitboard::toPoint(Bitboard::lowestIndex(pieces)));
+            result += value;
+            if (value > 0)
+                ++count;
+        }
+        return applyBonus(result, count);
+    }
+
+    EvalType getValue(Point piece) const
     {
         static const std::array<std::array<EvalType, boardSize>, boardSize>
             lookupTable{{
@@ -68,17 +121,11 @@ private:
                 {0.0000f, 0.8125f, 1.0000f, 1.1875f, 1.0000f, 0.8125f, 0.0000f},
                 {0.0000f, 0.0000f, 0.0000f, 0.0000f, 0.0000f, 0.0000f, 0.0000f},
             }};
+        return lookupTable[piece.x()][piece.y()];
+    }
 
-        EvalType result = 0;
-        int count = 0;
-        auto& pieces = player == 1 ? state.whitePieces : state.blackPieces;
-        for (const auto& piece : pieces)
-        {
-            auto value = lookupTable[piece.x()][piece.y()];
-            result += value;
-            if (value > 0)
-                ++count;
-        }
+    EvalType applyBonus(EvalType result, int count) const
+    {
         // Give a bonus to a high density of central pieces.
         if (count == 3)
             result *= 1.09375f;
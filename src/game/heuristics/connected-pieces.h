@@ -2,10 +2,10 @@
 
 #include "game/game.h"
 #include "game/drawboard.h"
+#include "game/bitboard-state.h"
 
 namespace DynamicConnect4 {
 
-using StateType = Game::StateType;
 using EvalType = Game::EvalType;
 
 // A measure of how connected the pieces of each player are.
@@ -14,15 +14,20 @@ using EvalType = Game::EvalType;
 class ConnectedPiecesV1
 {
 public:
-    EvalType operator()(const StateType& state) const
+    EvalType operator()(const State& state) const
     {
         Drawboard board{state};
         return eval(1, state, board) - eval(2, state, board);
     }
 
+    EvalType operator()(const BitboardState& state) const
+    {
+        return eval(state.whitePieces) - eval(state.blackPieces);
+    }
+
 private:
     EvalType
-        eval(int player, const StateType& state, const Drawboard& board) const
+        eval(int player, const State& state, const Drawboard& board) const
     {
         EvalType result = 0;
         // Since the pieces are sorted, we only need to look forward in the row,
@@ -43,6 +48,16 @@ private:
         }
         return result;
     }
+
+    EvalType eval(uint64_t pieces) const
+    {
+        using namespace Bitboard;
+
+        EvalType result = 0;
+        for (auto step : {antidiagonalStep, xStep, diagonalStep, yStep})
+            result += countConnectedPairs(pieces, step);
+        return result;
+    }
 };
 
 // A measure of how connected the pieces of each player are.
@@ -52,15 +67,20 @@ private:
 class ConnectedPiecesV2
 {
 public:
-    EvalType operator()(const StateType& state) const
+    EvalType operator()(const State& state) const
     {
         Drawboard board{state};
         return eval(1, state, board) - eval(2, state, board);
     }
 
+    EvalType operator()(const BitboardState& state) const
+    {
+        return eval(state.whitePieces) - eval(state.blackPieces);
+    }
+
 private:
     EvalType
-        eval(int player, const StateType& state, const Drawboard& board) const
+        eval(int player, const State& state, const Drawboard& board) const
     {
         static const EvalType diagonalFactor = 1.21875f;
 
@@ -83,6 +103,21 @@ private:
         }
         return result;
     }
+
+    EvalType eval(uint64_t pieces) const
+    {
+        using namespace Bitboard;
+
+        static const EvalType diagonalFactor = 1.21875f;
+
+        EvalType result = 0;
+        result +=
+            diagonalFactor * countConnectedPairs(pieces, antidiagonalStep);
+        result += countConnectedPairs(pieces, xStep);
+        result += diagonalFactor * countConnectedPairs(pieces, diagonalStep);
+        result += countConnectedPairs(pieces, yStep);
+        return result;
+    }
 };
 
 // A measure of how connected the pieces of each player are.
@@ -93,15 +128,22 @@ private:
 class ConnectedPiecesV3
 {
 public:
-    EvalType operator()(const StateType& state) const
+    EvalType operator()(const State& state) const
     {
         Drawboard board{state};
         return eval(1, state, board) - eval(2, state, board);
     }
 
+    EvalType operator()(const BitboardState& state) const
+    {
+        auto empty = Bitboard::boardMask &
+            ~(state.whitePieces | state.blackPieces);
+        return eval(state.whitePieces, empty) - eval(state.blackPieces, empty);
+    }
+
 private:
     EvalType
-        eval(int player, const StateType& state, const Drawboard& board) const
+        eval(int player, const State& state, const Drawboard& board) const
     {
         EvalType result = 0;
         auto& pieces = player == 1 ? state.whitePieces : state.blackPieces;
@@ -135,6 +177,26 @@ private:
         }
         return result;
     }
+
+    EvalType eval(uint64_t pieces, uint64_t empty) const
+    {
+        using namespace Bitboard;
+
+        EvalType result = 0;
+        for (auto step : {antidiagonalStep, xStep, diagonalStep, yStep})
+        {
+            result += popcount(pieces & (pieces >> step));
+
+            // Pieces two steps apart, where the middle square is on the board.
+            auto pairs = pieces & (boardMask >> step) & (pieces >> (2 * step));
+            result += popcount(pairs & (pieces >> step));
+            if (step == xStep || step == yStep)
+                result += 0.40625f * popcount(pairs & (empty >> step));
+            else
+                result += 0.09375f * popcount(pairs & (empty >> step));
+        }
+        return result;
+    }
 };
 
 // A measure of how connected the pieces of each player are.
@@ -143,15 +205,20 @@ private:
 class ConnectedPiecesV4
 {
 public:
-    EvalType operator()(const StateType& state) const
+    EvalType operator()(const State& state) const
     {
         Drawboard board{state};
         return eval(1, state, board) - eval(2, state, board);
     }
 
+    EvalType operator()(const BitboardState& state) const
+    {
+        return eval(state.whitePieces) - eval(state.blackPieces);
+    }
+
 private:
     EvalType
-        eval(int player, const StateType& state, const Drawboard& board) const
+        eval(int player, const State& state, const Drawboard& board) const
     {
         EvalType result = 0;
         // Since the pieces are sorted, we only need to look forward in the row,
@@ -187,5 +254,19 @@ private:
         }
         return result;
     }
+
+    EvalType eval(uint64_t pieces) const
+    {
+        using namespace Bitboard;
+
+        // Summing 2*N-1 over the pieces that start a run of N connected pieces
+        // is the same as counting every connected pair twice, less the number
+        // of pieces with a neighbour along the step.
+        EvalType result = 0;
+        for (auto step : {antidiagonalStep, xStep, diagonalStep, yStep})
+            result += 2 * countConnectedPairs(pieces, step) -
+                popcount(pieces & (pieces >> step));
+        return result;
+    }
 };
 }
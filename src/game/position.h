@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+
+namespace DynamicConnect4 {
+
+// A state of the game, along with the states of the game before it, which
+// the search needs to recognize repetitions.
+template <typename Game>
+struct Position
+{
+    typename Game::StateType state;
+    std::vector<typename Game::StateType> history;
+};
+
+// Parses a position of the form
+//      (startpos | state <player> <rows>) [moves <action>...]
+// where the rows are those of a state file separated by '/', and <player> = 1
+// or 2 is the player to move. The position is the state reached by playing the
+// actions. This throws std::runtime_error if the position is invalid or if one
+// of the actions is illegal.
+template <typename Game>
+Position<Game> parsePosition(const Game& game, const std::string& text)
+{
+    Position<Game> position;
+    std::stringstream in{text};
+    std::string token;
+    in >> token;
+    std::string actions;
+    if (token == "state")
+    {
+        int player;
+        in >> player;
+        std::string rows;
+        std::getline(in, rows);
+        auto end = rows.find(" moves");
+        if (end != std::string::npos)
+            actions = rows.substr(end + 1);
+        rows = rows.substr(0, end);
+        if (!in || (player != 1 && player != 2) || rows.empty())
+            throw std::runtime_error{"invalid position: " + text};
+
+        // The rows are read after the space that ends the player.
+        std::replace(std::begin(rows), std::end(rows), '/', '\n');
+        std::stringstream board{rows.substr(1) + "\n"};
+        if (!(board >> position.state))
+            throw std::runtime_error{"invalid position: " + text};
+        position.state.isPlayerOne = player == 1;
+    }
+    else if (token == "startpos")
+        std::getline(in, actions);
+    else
+        throw std::runtime_error{"invalid position: " + text};
+
+    std::stringstream moves{actions};
+    if (moves >> token && token != "moves")
+        throw std::runtime_error{"invalid position: " + text};
+    typename Game::ActionType action;
+    while (moves >> action)
+    {
+        if (game.isTerminal(position.state) ||
+            !game.isLegal(position.state, action))
+        {
+            std::stringstream ss;
+            ss << "illegal move: " << action;
+            throw std::runtime_error{ss.str()};
+        }
+        position.history.push_back(position.state);
+        game.makeMove(position.state, action);
+    }
+    if (!moves.eof())
+        throw std::runtime_error{"invalid position: " + text};
+    return position;
+}
+}
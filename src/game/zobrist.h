@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+namespace DynamicConnect4 {
+namespace Zobrist {
+
+// The random keys that make up the Zobrist hash of a position: one per player
+// and square of the bitboard, and one for the second player to move. The hash
+// of a position is the XOR of the keys of its pieces and side to move, so it
+// can be updated with a few XORs when a piece moves.
+struct Keys
+{
+    uint64_t pieces[2][64];
+    uint64_t playerTwo;
+};
+
+// The splitmix64 generator, which gives well distributed keys from any seed.
+constexpr uint64_t nextKey(uint64_t& seed)
+{
+    seed += 0x9e3779b97f4a7c15ull;
+    auto z = seed;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+constexpr Keys generateKeys()
+{
+    Keys keys{};
+    uint64_t seed = 0x44796e616d696334ull;
+    for (auto& player : keys.pieces)
+        for (auto& key : player)
+            key = nextKey(seed);
+    keys.playerTwo = nextKey(seed);
+    return keys;
+}
+
+// The keys are generated at compile time, so they are the same in every run
+// and there is no initialization order to worry about.
+constexpr Keys keys = generateKeys();
+}
+}
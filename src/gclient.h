@@ -3,43 +3,53 @@
 #include <iostream>
 #include <chrono>
 #include <string>
+#include <vector>
 #include <sstream>
 #include <algorithm>
-#include <limits>
-#include <thread>
+#include <future>
 
+#include "connection.h"
 #include "game/game.h"
+#include "game/bitboard-game.h"
 #include "game/heuristics.h"
 #include "search/iterative-alpha-beta.h"
+#include "search/engine.h"
+#include "search/time-manager.h"
 
 using namespace DynamicConnect4;
 using namespace Search;
 
-using StateType = Game::StateType;
-using ActionType = Game::ActionType;
-using EvalType = Game::EvalType;
+using StateType = BitboardGame::StateType;
+using ActionType = BitboardGame::ActionType;
+using EvalType = BitboardGame::EvalType;
 
-// This implements a telnet client that communicates with a game server using
-// standard input and output. Debug information is printed using std::cerr.
+// This implements a telnet client that communicates with a game server through
+// a connection, either using standard input and output or a TCP socket of its
+// own. Debug information is printed using std::cerr. The server does not end
+// the game on a repetition, so the search does not score repetitions as draws.
 class TelnetClient
 {
 public:
     TelnetClient(
+        Connection& connection,
         const std::string& gameId,
         int player,
         int timeLimitInMs,
+        int budgetInMs = 0,
+        const Options& options = Options{},
         bool debug = false)
-        : player{player}, search{game, debug}, timeLimitInMs{timeLimitInMs}
+        : connection(connection),
+          player{player},
+          engine{game, heuristic, debug, getOptions(options)},
+          clock{timeLimitInMs, budgetInMs}
     {
         std::string login = gameId + " " + (player == 1 ? "white" : "black");
         std::cerr << "Sending: " << login << std::endl;
-        std::cout << login << std::endl;
+        connection.send(login);
 
         do
         {
-            std::getline(std::cin, response);
-            if (response == "")
-                throw std::runtime_error{"connection closed"};
+            readLine();
             std::cerr << "Response: " << response << std::endl;
         } while (response != login);
     }
@@ -53,11 +63,14 @@ public:
             auto t1 = std::chrono::high_resolution_clock::now();
             isOurTurn = state.isPlayerOne ? (player == 1) : (player == 2);
             getAction();
+            history.push_back(state);
             state = game.getResult(state, action);
             auto t2 = std::chrono::high_resolution_clock::now();
             timeInMs =
                 std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1)
                     .count();
+            if (isOurTurn)
+                clock.update(timeInMs);
             printState();
             printTurn();
         }
@@ -65,64 +78,124 @@ public:
     }
 
 private:
+    Connection& connection;
     int player{};
 
-    Game game;
-    IterativeAlphaBeta<Game> search;
+    BitboardGame game;
+    Heuristic<ConnectedPiecesV1, CentralDominanceV2> heuristic{1.0f, 1.0f};
+    Engine<IterativeAlphaBeta<BitboardGame>> engine;
     StateType state;
+    // The positions of the game before the current one.
+    std::vector<StateType> history;
     ActionType action;
-    int timeLimitInMs{};
+    GameClock clock;
+    // The reply we expect from the opponent, and the search of the position
+    // it leads to, which goes on as our own search if they do play it.
+    bool hasPonderAction{false};
+    ActionType ponderAction;
+    std::future<ActionType> pondering;
     int move{0};
     bool isOurTurn{};
     int timeInMs{};
 
-    Heuristic<ConnectedPiecesV1, CentralDominanceV2> heuristic{1.0f, 1.0f};
-
     std::string response;
 
+    static Options getOptions(Options options)
+    {
+        options.repetitionDraws = false;
+        return options;
+    }
+
     void getAction()
     {
         if (isOurTurn)
         {
-            // This reduces our memory footprint by ensuring the search
-            // transposition table is only used by other threads.
-            std::thread compute{[&]() {
-                action = search.search(
-                    state,
-                    heuristic,
-                    timeLimitInMs,
-                    player == 1 ? true : false);
-            }};
-            compute.join();
+            if (pondering.valid())
+            {
+                // The opponent played the reply we expected, so the search we
+                // started then already has our action.
+                action = pondering.get();
+            }
+            else
+            {
+                engine.setHistory(history);
+                action =
+                    engine.start(state, player == 1, clock.getLimits()).get();
+            }
+            predictReply();
             send();
         }
         else
         {
             // Why sit idle while waiting for the opponent to play? Instead, we
-            // use that time to search for their best move. Note that we ignore
-            // the result, and we stop the search when we get a response, but
-            // the act of searching itself enables the search algorithm to fill
-            // the transposition table with nodes we will likely be searching
-            // soon, improving our performance.
-            std::thread compute{[&]() {
-                search.search(
-                    state,
-                    heuristic,
-                    std::numeric_limits<int>::max(),
-                    player == 1 ? false : true);
-            }};
-            action = receive();
-            search.stop();
-            if (compute.joinable())
-                compute.join();
+            // search the position after the reply we expect from them, and if
+            // they do play it, that search goes on with our time for the move.
+            // Otherwise, the search has still filled the transposition table
+            // with nodes we will likely be searching soon.
+            ponder();
+            try
+            {
+                action = receive();
+            }
+            catch (...)
+            {
+                stopPondering();
+                throw;
+            }
+            if (hasPonderAction && action == ponderAction &&
+                engine.ponderHit(clock.getLimits()))
+                std::cerr << "Ponder hit" << std::endl;
+            else
+                stopPondering();
         }
     }
 
+    // Takes the reply to our action from the principal variation of our
+    // search, if it has one.
+    void predictReply()
+    {
+        auto variation = engine.getPrincipalVariation();
+        hasPonderAction = variation.size() >= 2 && variation[0] == action;
+        if (hasPonderAction)
+            ponderAction = variation[1];
+    }
+
+    void ponder()
+    {
+        auto ponderHistory = history;
+        ponderHistory.push_back(state);
+        auto ponderState = state;
+        if (hasPonderAction)
+            ponderState = game.getResult(state, ponderAction);
+        if (game.isTerminal(ponderState))
+        {
+            // There is nothing to search after a reply that wins, so we
+            // search for the reply instead.
+            hasPonderAction = false;
+            ponderState = state;
+            ponderHistory.pop_back();
+        }
+        engine.setHistory(ponderHistory);
+        if (hasPonderAction)
+            std::cerr << "Pondering on: " << ponderAction << std::endl;
+
+        auto isMax = (player == 1) == hasPonderAction;
+        pondering = engine.start(ponderState, isMax);
+    }
+
+    void stopPondering()
+    {
+        engine.stop();
+        pondering.get();
+    }
+
     void send()
     {
         std::cerr << "Sending: " << action << std::endl;
-        std::cout << action << std::endl;
-        std::getline(std::cin, response);
+        std::stringstream out;
+        out << action;
+        connection.send(out.str());
+        readLine();
         std::cerr << "Response: " << response << std::endl;
     }
 
@@ -130,12 +203,7 @@ private:
     {
         ActionType action;
         auto actions = game.getActions(state);
-        std::getline(std::cin, response);
-        if (!std::cin)
-        {
-            std::cin.clear();
-            throw std::runtime_error{"invalid input"};
-        }
+        readLine();
         std::stringstream in{response};
         in >> action;
         if (!in)
@@ -152,6 +220,12 @@ private:
         return action;
     }
 
+    void readLine()
+    {
+        if (!connection.receive(response))
+            throw std::runtime_error{"connection closed"};
+    }
+
     void printState()
     {
         std::cerr << state;
@@ -161,9 +235,9 @@ private:
     {
         std::cerr << "move #" << move << std::endl;
         if (isOurTurn)
-            std::cerr << search.getLastCount()
+            std::cerr << engine.getLastCount()
                       << " nodes searched with max depth "
-                      << search.getLastDepth() << std::endl;
+                      << engine.getLastDepth() << std::endl;
         std::cerr << "turn took " << (timeInMs / 1000.0) << " seconds"
                   << std::endl;
         std::cerr << "action: " << action << std::endl;
@@ -1,62 +1,115 @@
 #include <iostream>
+#include <fstream>
+#include <memory>
 #include <chrono>
 #include <string>
+#include <vector>
 #include <algorithm>
 
 #include "args.h"
+#include "connection.h"
 #include "gclient.h"
+#include "uci-client.h"
 
 #include "game/game.h"
+#include "game/bitboard-game.h"
 #include "game/heuristics.h"
 #include "search/minimax.h"
 #include "search/alpha-beta.h"
 #include "search/ordered-alpha-beta.h"
 #include "search/iterative-alpha-beta.h"
+#include "search/mtdf.h"
+#include "search/engine.h"
+#include "search/time-manager.h"
+#include "util/tee-buffer.h"
 
 using namespace Args;
 using namespace DynamicConnect4;
 using namespace Search;
 
-using StateType = Game::StateType;
-using ActionType = Game::ActionType;
-using EvalType = Game::EvalType;
+using StateType = BitboardGame::StateType;
+using ActionType = BitboardGame::ActionType;
+using EvalType = BitboardGame::EvalType;
 
 void playGame(
     int humanPlayer,
     int timeLimitInMs,
+    int budgetInMs,
     const StateType& initialState,
+    const Options& options,
     bool debug);
-ActionType getPlayerAction(const Game& game, const StateType& state);
+ActionType getPlayerAction(const BitboardGame& game, const StateType& state);
 void print(const StateType& state);
 
 int main(int argc, char** argv)
 {
     try
     {
-        auto args = parse<Game>(argc, argv);
+        auto args = parse<BitboardGame>(argc, argv);
+
+        // The debug information goes to the log file as well as to stderr,
+        // until the end of the program.
+        std::ofstream log;
+        std::unique_ptr<Util::TeeBuffer> logBuffer;
+        auto stderrBuffer = std::cerr.rdbuf();
+        if (!args.logFile.empty())
+        {
+            log.open(args.logFile, std::ios::app);
+            if (!log)
+                throw std::runtime_error{"cannot open " + args.logFile};
+            logBuffer.reset(new Util::TeeBuffer{stderrBuffer, log.rdbuf()});
+            std::cerr.rdbuf(logBuffer.get());
+        }
+        struct BufferGuard
+        {
+            std::streambuf* buffer;
+            ~BufferGuard()
+            {
+                std::cerr.rdbuf(buffer);
+            }
+        } bufferGuard{stderrBuffer};
+
         if (args.help)
         {
-            printUsage<Game>(argv[0]);
+            printUsage<BitboardGame>(argv[0]);
         }
         else if (args.telnet)
         {
-            TelnetClient client{args.gameId,
+            std::unique_ptr<Connection> connection;
+            if (args.host.empty())
+                connection.reset(new StreamConnection{});
+            else
+                connection.reset(new SocketConnection{args.host, args.port});
+            TelnetClient client{*connection,
+                                args.gameId,
                                 args.player,
                                 args.timeLimitInMs,
+                                args.budgetInMs,
+                                args.options,
                                 args.debug};
             client.play();
         }
+        else if (args.uci)
+        {
+            UciClient client{args.options, args.debug};
+            client.run();
+        }
         else
         {
             playGame(
-                args.player, args.timeLimitInMs, args.initialState, args.debug);
+                args.player,
+                args.timeLimitInMs,
+                args.budgetInMs,
+                args.initialState,
+                args.options,
+                args.debug);
         };
         return 0;
     }
     catch (ArgsError& e)
     {
         std::cerr << "Error: " << e.what() << std::endl;
-        printUsage<Game>(argv[0]);
+        printUsage<BitboardGame>(argv[0]);
         return 1;
     }
     catch (std::exception& e)
@@ -73,22 +126,27 @@ int main(int argc, char** argv)
 void playGame(
     int humanPlayer,
     int timeLimitInMs,
+    int budgetInMs,
     const StateType& initialState,
+    const Options& options,
     bool debug)
 {
-    Game game;
-    IterativeAlphaBeta<Game> playerOneSearch{game, debug};
-    IterativeAlphaBeta<Game> playerTwoSearch{game, debug};
+    BitboardGame game;
+    auto playerOneHeuristic =
+        Heuristic<ConnectedPiecesV1, CentralDominanceV2>{1.0f, 1.0f};
+    auto playerTwoHeuristic =
+        Heuristic<ConnectedPiecesV4, CentralDominanceV2>{1.0f, 1.0f};
+    Engine<IterativeAlphaBeta<BitboardGame>> playerOneEngine{
+        game, playerOneHeuristic, debug, options};
+    Engine<IterativeAlphaBeta<BitboardGame>> playerTwoEngine{
+        game, playerTwoHeuristic, debug, options};
     int playerOneWins = 0, playerTwoWins = 0, draws = 0;
     while (true)
     {
         StateType state = initialState;
         ActionType action;
-
-        auto playerOneHeuristic =
-            Heuristic<ConnectedPiecesV1, CentralDominanceV2>{1.0f, 1.0f};
-        auto playerTwoHeuristic =
-            Heuristic<ConnectedPiecesV4, CentralDominanceV2>{1.0f, 1.0f};
+        GameClock playerOneClock{timeLimitInMs, budgetInMs};
+        GameClock playerTwoClock{timeLimitInMs, budgetInMs};
 
         print(state);
         std::cout << "player one evaluation: " << playerOneHeuristic(state)
@@ -98,43 +156,52 @@ void playGame(
         std::cout << std::endl;
 
         int move = 0;
-        std::array<StateType, 5> previousStates;
+        std::vector<StateType> history;
         while (!game.isTerminal(state))
         {
             ++move;
             auto t1 = std::chrono::high_resolution_clock::now();
+            playerOneEngine.setHistory(history);
+            playerTwoEngine.setHistory(history);
+            history.push_back(state);
             if (state.isPlayerOne)
             {
                 action = humanPlayer == 1 ?
                     getPlayerAction(game, state) :
-                    playerOneSearch.search(
-                        state, playerOneHeuristic, timeLimitInMs, true);
+                    playerOneEngine
+                        .start(state, true, playerOneClock.getLimits())
+                        .get();
                 state = game.getResult(state, action);
                 print(state);
                 std::cout << "move #" << move << std::endl;
                 if (humanPlayer != 1)
-                    std::cout << playerOneSearch.getLastCount()
+                    std::cout << playerOneEngine.getLastCount()
                               << " nodes searched with max depth "
-                              << playerOneSearch.getLastDepth() << std::endl;
+                              << playerOneEngine.getLastDepth() << std::endl;
             }
             else
             {
                 action = humanPlayer == 2 ?
                     getPlayerAction(game, state) :
-                    playerTwoSearch.search(
-                        state, playerTwoHeuristic, timeLimitInMs, false);
+                    playerTwoEngine
+                        .start(state, false, playerTwoClock.getLimits())
+                        .get();
                 state = game.getResult(state, action);
                 print(state);
                 std::cout << "move #" << move << std::endl;
                 if (humanPlayer != 2)
-                    std::cout << playerTwoSearch.getLastCount()
+                    std::cout << playerTwoEngine.getLastCount()
                               << " nodes searched with max depth "
-                              << playerTwoSearch.getLastDepth() << std::endl;
+                              << playerTwoEngine.getLastDepth() << std::endl;
             }
             auto t2 = std::chrono::high_resolution_clock::now();
             auto ms =
                 std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1)
                     .count();
+            if (state.isPlayerOne)
+                playerTwoClock.update(ms);
+            else
+                playerOneClock.update(ms);
             std::cout << "turn took " << (ms / 1000.0) << " seconds"
                       << std::endl;
             std::cout << "action: " << action << std::endl;
@@ -145,16 +212,11 @@ void playGame(
                       << std::endl;
             std::cout << std::endl;
 
-            std::copy(
-                std::begin(previousStates) + 1,
-                std::end(previousStates),
-                std::begin(previousStates));
-            previousStates.back() = state;
-            if (previousStates.front() == previousStates.back())
+            if (game.isRepetition(state, history))
                 break;
         }
 
-        if (previousStates.front() == previousStates.back())
+        if (game.isRepetition(state, history))
         {
             std::cout << "draw!" << std::endl;
             ++draws;
@@ -182,7 +244,7 @@ void playGame(
     }
 }
 
-ActionType getPlayerAction(const Game& game, const StateType& state)
+ActionType getPlayerAction(const BitboardGame& game, const StateType& state)
 {
     ActionType action;
     auto actions = game.getActions(state);
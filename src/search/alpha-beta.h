@@ -13,13 +13,18 @@ namespace Search {
 //      StateType - The type of the state representation for a position.
 //      ActionType - The type of an action in the game.
 //      EvalType - The type of a numerical position evaluation.
+//      ActionListType - The type of a list of actions, with random access
+//          iterators, such as std::vector<ActionType>.
 //
-//      std::vector<ActionType> getActions(StateType)
-//          A method to get a vector with the possible actions
+//      ActionListType getActions(StateType)
+//          A method to get a list with the possible actions
 //          that can be taken from a given state.
 //
-//      StateType getResult(StateType, ActionType)
-//          A method to apply an action to a state and get the next state.
+//      void makeMove(StateType&, ActionType)
+//          A method to apply an action to a state in place.
+//
+//      void unmakeMove(StateType&, ActionType)
+//          A method to undo an action applied to a state with makeMove.
 //
 //      bool isTerminal(StateType)
 //          A method to check if a state is terminal.
@@ -41,7 +46,7 @@ public:
     }
 
     ActionType search(
-        const StateType& state, Heuristic heuristic, int depth, bool isMax)
+        StateType state, Heuristic heuristic, int depth, bool isMax)
     {
         count = 1;
         this->heuristic = heuristic;
@@ -56,8 +61,9 @@ public:
         auto bestAction = std::make_pair(actions.front(), init);
         for (const auto& action : actions)
         {
-            auto value = alphaBeta(
-                game.getResult(state, action), alpha, beta, depth - 1, !isMax);
+            game.makeMove(state, action);
+            auto value = alphaBeta(state, alpha, beta, depth - 1, !isMax);
+            game.unmakeMove(state, action);
             if (isMax)
             {
                 alpha = std::max(alpha, value);
@@ -77,7 +83,7 @@ public:
         return bestAction.first;
     }
 
-    int getLastCount() const
+    long long getLastCount() const
     {
         return count;
     }
@@ -90,11 +96,11 @@ public:
 private:
     Game& game;
     int depth{};
-    int count{0};
+    long long count{0};
     Heuristic heuristic;
 
     EvalType alphaBeta(
-        const StateType& state,
+        StateType& state,
         EvalType alpha,
         EvalType beta,
         int depth,
@@ -113,8 +119,9 @@ private:
         auto actions = game.getActions(state);
         for (const auto& action : actions)
         {
-            auto value = alphaBeta(
-                game.getResult(state, action), alpha, beta, depth - 1, !isMax);
+            game.makeMove(state, action);
+            auto value = alphaBeta(state, alpha, beta, depth - 1, !isMax);
+            game.unmakeMove(state, action);
             if (isMax)
             {
                 bestValue = std::max(bestValue, value);
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <vector>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <utility>
+
+#include "search/options.h"
+#include "search/limits.h"
+
+namespace Search {
+
+// A class running the searches of a search engine of type Searcher, such as
+// IterativeAlphaBeta or MTDf, on a thread of its own that lives as long as it
+// does. A search is started with start(), which returns right away with a
+// future of the action found, so the calling thread is free to do other work,
+// such as reading from the network, while the search runs. The search in
+// progress can be stopped, given a new time limit when the position it
+// pondered on comes up, and asked for its best action so far.
+//
+// Only one search runs at a time, so starting a search stops the one in
+// progress first.
+//
+// Searcher must define:
+//      StateType, ActionType, Heuristic, Progress and Listener - The types of
+//          a state, an action, a heuristic, the progress of a search and a
+//          function to call with the progress after each iteration.
+//
+//      Searcher(Game&, bool, const Options&)
+//          A constructor taking a game, the debug flag and the options.
+//
+//      ActionType search(StateType, Heuristic, Limits, bool)
+//          A method to search a state within some limits for either player.
+//
+//      long long getNextSearchId() and void stop(long long)
+//          Methods to get the id of the next search, and to stop the search
+//          of an id whether it has started or not.
+//
+//      bool ponderHit(Limits), Progress getProgress(),
+//      void setListener(Listener),
+//      std::vector<ActionType> getPrincipalVariation(StateType),
+//      void setHistory(std::vector<StateType>),
+//      long long getLastCount() and int getLastDepth()
+//          The methods of IterativeAlphaBeta of the same names.
+template <typename Searcher>
+class Engine
+{
+public:
+    using StateType = typename Searcher::StateType;
+    using ActionType = typename Searcher::ActionType;
+    using Heuristic = typename Searcher::Heuristic;
+    using Progress = typename Searcher::Progress;
+    using Listener = typename Searcher::Listener;
+    // A function called with the action found once a search returns.
+    using Callback = std::function<void(const ActionType&)>;
+
+    template <typename Game>
+    Engine(
+        Game& game,
+        Heuristic heuristic,
+        bool debug = false,
+        const Options& options = Options{})
+        : searcher{game, debug, options},
+          heuristic{heuristic},
+          thread{[this]() { run(); }}
+    {
+    }
+
+    Engine(const Engine&) = delete;
+    Engine& operator=(const Engine&) = delete;
+
+    ~Engine()
+    {
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            stop(lock);
+            isQuitting = true;
+        }
+        condition.notify_all();
+        thread.join();
+    }
+
+    // Starts a search of a state for either player, with the positions given
+    // to setHistory() before it. The callback, if any, is called on the thread
+    // of the engine once the search returns, before the future is ready.
+    std::future<ActionType> start(
+        const StateType& state,
+        bool isMax,
+        const Limits& limits = Limits{},
+        Callback callback = Callback{})
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        stop(lock);
+        job = Job{state, isMax, limits, history, callback, {}};
+        hasJob = true;
+        // The thread of the engine is idle, so the search of the job is the
+        // next one of the searcher.
+        searchId = searcher.getNextSearchId();
+        auto result = job.promise.get_future();
+        condition.notify_all();
+        return result;
+    }
+
+    // Stops the search in progress, if any, and waits for it to return. Its
+    // future then holds its best action so far.
+    void stop()
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        stop(lock);
+    }
+
+    // Gives the search in progress new limits starting from now. This fails
+    // if no search is in progress, or if it has yet to start.
+    bool ponderHit(const Limits& limits)
+    {
+        return searcher.ponderHit(limits);
+    }
+
+    // Sets a function to call on the thread of the engine after each complete
+    // iteration of the searches to come.
+    void setListener(Listener listener)
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        stop(lock);
+        searcher.setListener(listener);
+    }
+
+    // Sets the positions of the game before the state of the next search.
+    void setHistory(const std::vector<StateType>& history)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        this->history = history;
+    }
+
+    // Gives the best action, value and depth of the search in progress so
+    // far, or of the last search.
+    Progress getProgress() const
+    {
+        return searcher.getProgress();
+    }
+
+    // Gives the principal variation from the state of the search in progress
+    // so far, or of the last search.
+    std::vector<ActionType> getPrincipalVariation() const
+    {
+        StateType state;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            state = root;
+        }
+        return searcher.getPrincipalVariation(state);
+    }
+
+    // Gives the statistics of the last search, which must have returned.
+    long long getLastCount() const
+    {
+        return searcher.getLastCount();
+    }
+
+    int getLastDepth() const
+    {
+        return searcher.getLastDepth();
+    }
+
+private:
+    struct Job
+    {
+        StateType state;
+        bool isMax;
+        Limits limits;
+        std::vector<StateType> history;
+        Callback callback;
+        std::promise<ActionType> promise;
+    };
+
+    Searcher searcher;
+    Heuristic heuristic;
+
+    // The mutex guards the job waiting to run and the state of the thread.
+    mutable std::mutex mutex;
+    std::condition_variable condition;
+    Job job;
+    bool hasJob{false};
+    bool isRunning{false};
+    // The id of the search of the job waiting to run or running.
+    long long searchId{0};
+    bool isQuitting{false};
+    StateType root;
+    std::vector<StateType> history;
+
+    std::thread thread;
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        while (true)
+        {
+            condition.wait(lock, [this]() { return hasJob || isQuitting; });
+            if (isQuitting)
+                return;
+            auto current = std::move(job);
+            hasJob = false;
+            isRunning = true;
+            root = current.state;
+            lock.unlock();
+
+            ActionType action{};
+            std::exception_ptr error;
+            try
+            {
+                searcher.setHistory(current.history);
+                action = searcher.search(
+                    current.state, heuristic, current.limits, current.isMax);
+                if (current.callback)
+                    current.callback(action);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            lock.lock();
+            isRunning = false;
+            if (error)
+                current.promise.set_exception(error);
+            else
+                current.promise.set_value(action);
+            condition.notify_all();
+        }
+    }
+
+    // Stops the search of the job, which may have yet to start, and waits
+    // for the thread of the engine to be done with it.
+    void stop(std::unique_lock<std::mutex>& lock)
+    {
+        if (hasJob || isRunning)
+            searcher.stop(searchId);
+        condition.wait(lock, [this]() { return !hasJob && !isRunning; });
+    }
+};
+}
@@ -1,16 +1,16 @@
 #pragma once
 
-#include <map>
 #include <vector>
 #include <limits>
+#include <cmath>
 #include <algorithm>
-#include <utility>
 #include <functional>
-#include <chrono>
 #include <iostream>
-#include <atomic>
+#include <thread>
 
-#include "search/transposition-table.h"
+#include "search/options.h"
+#include "search/limits.h"
+#include "search/search-base.h"
 
 namespace Search {
 
@@ -21,46 +21,100 @@ namespace Search {
 //          after each iteration using a stable sort. This allows it to get
 //          better move ordering in the next iteration. Being a stable sort, it
 //          also ensures that actions keep their relative ordering from previous
-//          iterations should they compare equally in this one.
+//          iterations should they compare equally in this one. An iteration
+//          predicted to end after the time limit is not started, and when an
+//          iteration runs out of time, an action it proved better than the
+//          best one of the previous iteration is still returned.
 //      2) The moves at every node of the search tree other than the root are
-//          sorted according to their heuristic values to allow for better move
-//          ordering. The exception is those nodes at a depth d with branching
-//          factor b for which the cost of sorting (c*b*lg(b)) and evaluating
-//          heuristics (h*b) is mathematically higher than the benefit obtained
-//          through ordering (h*b^floor(d/2)). This corresponds to sorting for
-//          nodes of depth at least 4. Note that in this case, the depth is
-//          measured as the distance from the leaves of the search tree.
-//      3) A transposition table is used to keep track of the moves seen so far.
+//          sorted to allow for better move ordering, in one of two ways chosen
+//          in the options:
+//          a) By the killer moves of the ply, which are the last two moves to
+//              produce a cutoff at the same distance from the root, then by
+//              the history heuristic, which counts the cutoffs each move has
+//              produced so far weighted by the depth of its subtree.
+//          b) By their heuristic values. The exception is those nodes at a
+//              depth d with branching factor b for which the cost of sorting
+//              (c*b*lg(b)) and evaluating heuristics (h*b) is mathematically
+//              higher than the benefit obtained through ordering
+//              (h*b^floor(d/2)). This corresponds to sorting for nodes of depth
+//              at least 4. Note that in this case, the depth is measured as the
+//              distance from the leaves of the search tree.
+//      3) Principal variation search is used. The first action of a node is
+//          searched with the full window, and the following ones with a null
+//          window, which only proves that they are no better than the first.
+//          An action that turns out to be better is searched again with the
+//          full window. Each depth is also first searched within a small
+//          window around the value found two plies before (aspiration
+//          window), and searched again with an open window on the side where
+//          that fails. Both can be turned off in the options.
+//      4) A transposition table is used to keep track of the moves seen so far.
+//          It is kept from one search to the next, with entries from earlier
+//          searches being the first to be replaced. It also keeps the best
+//          action of each state, which is searched before any other action is
+//          generated or sorted, since it often produces a cutoff on its own.
+//      5) The actions ordered late at a node are first searched with a reduced
+//          depth, and near the leaves, the actions of a node whose heuristic
+//          value is far outside of the window are skipped unless they win.
+//          Both can be turned off in the options.
+//      6) The keys of the positions on the path from the root, and of the
+//          positions of the game before the root, are kept to score a position
+//          that repeats as a draw right away, which cuts the cycles of pieces
+//          moving back and forth out of the search. This can be turned off in
+//          the options for rules without a repetition draw.
+//      7) It can search with several threads (lazy SMP). Helper threads run the
+//          same iterative search as the main thread with a different order of
+//          the root actions and starting depth, and share their results only
+//          through the transposition table. Only the main thread decides which
+//          action to return.
+//
+// The nodes below the root are searched by SearchBase, which MTDf shares.
 //
 // Game must define:
 //      StateType - The type of the state representation for a position.
 //      ActionType - The type of an action in the game.
 //      EvalType - The type of a numerical position evaluation.
+//      ActionListType - The type of a list of actions, with random access
+//          and a static capacity(), such as Util::StaticVector<ActionType, N>.
+//
+//      static const int actionCodeCount, static int getActionCode(ActionType)
+//      and static ActionType getAction(int)
+//          The methods to encode actions required by TranspositionTable.
 //
-//      std::vector<ActionType> getActions(StateType)
-//          A method to get a vector with the possible actions
+//      ActionListType getActions(StateType)
+//          A method to get a list with the possible actions
 //          that can be taken from a given state.
 //
-//      StateType getResult(StateType, ActionType)
-//          A method to apply an action to a state and get the next state.
+//      bool isLegal(StateType, ActionType)
+//          A method to check if an action can be taken from a given state.
+//
+//      void makeMove(StateType&, ActionType)
+//          A method to apply an action to a state in place.
+//
+//      void unmakeMove(StateType&, ActionType)
+//          A method to undo an action applied to a state with makeMove.
 //
 //      bool isTerminal(StateType)
 //          A method to check if a state is terminal.
 //
 //      EvalType getUtility(StateType)
 //          A method to get the utility value of a given terminal state.
+//
+//      EvalType getDrawUtility()
+//          A method to get the utility value of a position that repeats.
 template <typename Game>
-class IterativeAlphaBeta
+class IterativeAlphaBeta : public SearchBase<Game>
 {
-public:
-    using StateType = typename Game::StateType;
-    using ActionType = typename Game::ActionType;
-    using EvalType = typename Game::EvalType;
-
-    using Heuristic = std::function<EvalType(const StateType&)>;
+    using Base = SearchBase<Game>;
 
-    IterativeAlphaBeta(Game& game, bool debug = false)
-        : game(game), transpositionTable{4 * 1024 * 1024}, debug{debug}
+public:
+    using typename Base::StateType;
+    using typename Base::ActionType;
+    using typename Base::EvalType;
+    using typename Base::Heuristic;
+
+    IterativeAlphaBeta(
+        Game& game, bool debug = false, const Options& options = Options{})
+        : Base{game, debug, options}
     {
     }
 
@@ -70,13 +124,72 @@ public:
         int timeLimitInMs,
         bool isMax)
     {
-        count = 1;
-        this->heuristic = heuristic;
-        this->timeLimitInMs = timeLimitInMs;
-        startTime = std::chrono::high_resolution_clock::now();
+        return search(
+            state, heuristic, Limits{timeLimitInMs, timeLimitInMs}, isMax);
+    }
 
+    ActionType search(
+        const StateType& state,
+        Heuristic heuristic,
+        const Limits& limits,
+        bool isMax)
+    {
+        if (!startSearch(state, heuristic, limits, options.threads))
+            return ActionType{};
+
+        std::vector<std::thread> helpers;
+        for (size_t i = 1; i < workers.size(); ++i)
+            helpers.emplace_back(
+                [&, i]() { iterate(workers[i], state, isMax); });
+        auto result = iterate(workers.front(), state, isMax);
+        control.stop();
+        for (auto& helper : helpers)
+            helper.join();
+
+        finishSearch(result);
+        return result.action;
+    }
+
+private:
+    using typename Base::ValueListType;
+    using typename Base::Worker;
+    using typename Base::Result;
+
+    using Base::maxPly;
+    using Base::noRepetition;
+    using Base::game;
+    using Base::transpositionTable;
+    using Base::workers;
+    using Base::hasher;
+    using Base::control;
+    using Base::debug;
+    using Base::options;
+
+    using Base::startSearch;
+    using Base::finishSearch;
+    using Base::reportIteration;
+    using Base::alphaBeta;
+    using Base::storeRoot;
+    using Base::heuristicSort;
+    using Base::checkTime;
+    using Base::isTimeUp;
+
+    Result iterate(Worker& worker, StateType state, bool isMax)
+    {
         auto actions = game.getActions(state);
-        std::map<ActionType, EvalType> values;
+        ValueListType values;
+        values.resize(actions.size());
+
+        // The helpers start from a different order of the root actions and
+        // every other one starts one ply deeper, which spreads the threads
+        // over different parts of the tree.
+        bool isMain = worker.id == 0;
+        if (!isMain)
+            std::rotate(
+                std::begin(actions),
+                std::begin(actions) + worker.id % actions.size(),
+                std::end(actions));
+        auto initialDepth = 1 + worker.id % 2;
 
         auto winIndicator = isMax ? std::numeric_limits<EvalType>::max() :
                                     std::numeric_limits<EvalType>::lowest();
@@ -88,222 +201,197 @@ public:
         else
             comp = std::less<EvalType>{};
 
-        if (debug)
+        if (debug && isMain)
         {
             std::cerr << "========== actions ==========" << std::endl;
         }
 
-        for (int depth = 1;; ++depth)
+        worker.path.push_back(hasher(state));
+
+        // The value of the best action of the last complete iteration, and
+        // of the last complete iterations of odd and even depths.
+        auto bestValue = EvalType{};
+        EvalType parityValues[2]{};
+        for (int depth = initialDepth;; ++depth)
         {
-            auto alpha = std::numeric_limits<EvalType>::lowest();
-            auto beta = std::numeric_limits<EvalType>::max();
+            long long initialCount = worker.count;
+            worker.repetitionPly = noRepetition;
+            if (depth > maxPly)
+            {
+                // Repetitions can make every line end in a draw, in which case
+                // the iterations would go on with no end.
+                return Result{actions.front(), bestValue, depth - 1};
+            }
+
+            auto lower = std::numeric_limits<EvalType>::lowest();
+            auto upper = std::numeric_limits<EvalType>::max();
+            if (options.aspirationWindows && depth >= initialDepth + 2 &&
+                parityValues[depth % 2] != lossIndicator)
+            {
+                auto delta = static_cast<EvalType>(options.aspirationWindow);
+                lower = parityValues[depth % 2] - delta;
+                upper = parityValues[depth % 2] + delta;
+            }
 
-            for (const auto& action : actions)
+            // The action proven better than the best one of the previous
+            // iteration, if any, which is kept should we run out of time.
+            size_t provenIndex = 0;
+            auto provenValue = bestValue;
+            while (!checkTime(worker))
             {
-                auto value = alphaBeta(
-                    game.getResult(state, action),
-                    alpha,
-                    beta,
-                    depth - 1,
-                    !isMax);
-                if (value == winIndicator)
+                auto alpha = lower, beta = upper;
+                auto iterationValue = isMax ? lower : upper;
+                for (size_t i = 0; i < actions.size(); ++i)
                 {
-                    // We found our goal, so we can stop searching.
-                    this->depth = depth;
-                    return action;
+                    EvalType value;
+                    if (!searchRootAction(
+                            worker, state, actions[i], alpha, beta, depth,
+                            isMax, i == 0, value))
+                        break;
+                    if (value == winIndicator)
+                    {
+                        // We found our goal, so we can stop searching.
+                        if (isMain)
+                            storeRoot(worker, state, value, depth, actions[i]);
+                        return Result{actions[i], value, depth};
+                    }
+                    values[i] = value;
+                    if (i > 0 && comp(value, iterationValue))
+                    {
+                        provenIndex = i;
+                        provenValue = value;
+                    }
+                    if (isMax)
+                    {
+                        iterationValue = std::max(iterationValue, value);
+                        alpha = std::max(alpha, value);
+                    }
+                    else
+                    {
+                        iterationValue = std::min(iterationValue, value);
+                        beta = std::min(beta, value);
+                    }
+                    if (alpha >= beta || isTimeUp())
+                        break;
                 }
-                values[action] = value;
-                if (isMax)
-                    alpha = std::max(alpha, value);
+
+                // Search again if the value is outside of the window.
+                if (iterationValue <= lower &&
+                    lower != std::numeric_limits<EvalType>::lowest())
+                    lower = std::numeric_limits<EvalType>::lowest();
+                else if (
+                    iterationValue >= upper &&
+                    upper != std::numeric_limits<EvalType>::max())
+                    upper = std::numeric_limits<EvalType>::max();
                 else
-                    beta = std::min(beta, value);
+                    break;
             }
 
-            if (debug)
+            if (debug && isMain)
             {
-                std::cerr << "searched " << count << " nodes so far at depth "
-                          << depth << " with " << transpositionTable.size()
-                          << " nodes cached and a hit rate of "
-                          << transpositionTable.getHitRate() << std::endl;
+                std::cerr << "searched " << worker.count
+                          << " nodes so far at depth " << depth
+                          << " with a table usage of "
+                          << transpositionTable.getUsage()
+                          << " and a hit rate of "
+                          << static_cast<double>(worker.hits) / worker.probes
+                          << std::endl;
             }
 
-            if (isTimeUp())
+            if (checkTime(worker))
             {
-                // We ran out of time, so return the previous best action.
-                this->depth = depth - 1;
-                return actions.front();
+                // We ran out of time, so return the previous best action,
+                // unless this iteration proved another one better.
+                if (provenIndex > 0)
+                    return Result{actions[provenIndex], provenValue, depth - 1};
+                return Result{actions.front(), bestValue, depth - 1};
             }
 
             // Sort the actions so the best ones are first.
             // Given a stable sort, this will also ensure that better actions at
             // a lower depth will be ahead of now equal valued actions.
-            actions = heuristicSort(actions, comp, values);
+            heuristicSort(actions, comp, values);
+            bestValue = values.front();
+            parityValues[depth % 2] = bestValue;
+            if (isMain)
+            {
+                storeRoot(worker, state, bestValue, depth, actions.front());
+                reportIteration(actions.front(), bestValue, depth);
+            }
 
-            if (debug)
+            if (debug && isMain)
             {
                 std::cerr << "depth " << depth << " => ";
-                for (const auto& action : actions)
-                    std::cerr << action << ": " << values[action] << "; ";
+                for (size_t i = 0; i < actions.size(); ++i)
+                    std::cerr << actions[i] << ": " << values[i] << "; ";
                 std::cerr << std::endl;
             }
 
-            if (values[actions.front()] == lossIndicator)
+            if (bestValue == lossIndicator)
             {
-                // If we are guaranteed to lose, it is better to return now and
-                // clear the transposition table. This is because we want to
-                // recompute the path to the most distant loss in the next move
-                // in case we are playing against a non-optimal player or an
-                // optimal player with restricted search depth.
-                transpositionTable.clear();
-                this->depth = depth;
-                return actions.front();
+                // If we are guaranteed to lose, there is no point in searching
+                // any deeper.
+                return Result{actions.front(), bestValue, depth};
             }
-        }
-    }
 
-    void stop()
-    {
-        timeLimitInMs = 0;
-    }
-
-    int getLastCount() const
-    {
-        return count;
-    }
-
-    int getLastDepth() const
-    {
-        return depth;
+            if (isMain)
+            {
+                auto canIterate =
+                    control.update(depth, worker.count - initialCount);
+                if (debug)
+                {
+                    std::cerr << "effective branching factor "
+                              << control.getBranchingFactor() << std::endl;
+                }
+                if (!canIterate)
+                    return Result{actions.front(), bestValue, depth};
+            }
+        }
     }
 
-private:
-    Game& game;
-    int count{0};
-    int depth{0};
-    Heuristic heuristic;
-
-    TranspositionTable<Game> transpositionTable;
-
-    std::atomic<int> timeLimitInMs{};
-    std::chrono::high_resolution_clock::time_point startTime;
-
-    bool debug{};
-
-    EvalType alphaBeta(
-        const StateType& state,
+    // Searches an action of the root as searchChild does, and tells whether
+    // the value found is proven, which it is not when the search runs out of
+    // time. An action that fails high on its null window search is better
+    // than the best one so far, so when only its search with the full window
+    // runs out of time, the bound from the null window search is kept.
+    bool searchRootAction(
+        Worker& worker,
+        StateType& state,
+        const ActionType& action,
         EvalType alpha,
         EvalType beta,
         int depth,
-        bool isMax)
+        bool isMax,
+        bool isFirst,
+        EvalType& value)
     {
-        ++count;
-        if (game.isTerminal(state))
-            return game.getUtility(state);
-        else if (depth == 0 || isTimeUp())
-            return heuristic(state);
-
-        auto savedAlpha = alpha, savedBeta = beta;
-        auto entry = transpositionTable.find(state);
-        if (entry.first && entry.second.depth >= depth)
+        game.makeMove(state, action);
+        worker.path.push_back(hasher(state));
+        bool isProven;
+        if (isFirst || !options.principalVariation)
         {
-            auto value = entry.second.value;
-            auto flag = entry.second.flag;
-            if (flag == Flag::exact)
-                return value;
-            else if (flag == Flag::lowerBound)
-                alpha = std::max(alpha, value);
-            else if (flag == Flag::upperBound)
-                beta = std::min(beta, value);
-
-            if (alpha >= beta)
-                return value;
+            value = alphaBeta(worker, state, alpha, beta, depth - 1, 1, !isMax);
+            isProven = !isTimeUp();
         }
-
-        auto init = isMax ? std::numeric_limits<EvalType>::lowest() :
-                            std::numeric_limits<EvalType>::max();
-        std::function<bool(EvalType, EvalType)> comp;
-        if (isMax)
-            comp = std::greater<EvalType>{};
         else
-            comp = std::less<EvalType>{};
-
-        auto bestValue = init;
-        auto actions = game.getActions(state);
-        // Sorting the actions using the heuristic helps us consider
-        // the best actions first.
-        if (depth >= 4)
-            actions = heuristicSort(actions, state, comp);
-        for (const auto& action : actions)
         {
-            auto value = alphaBeta(
-                game.getResult(state, action), alpha, beta, depth - 1, !isMax);
-            if (isMax)
+            auto nullAlpha = isMax ? alpha : std::nextafter(beta, alpha);
+            auto nullBeta = isMax ? std::nextafter(alpha, beta) : beta;
+            value = alphaBeta(
+                worker, state, nullAlpha, nullBeta, depth - 1, 1, !isMax);
+            isProven = !isTimeUp();
+            if (isProven && value > alpha && value < beta)
             {
-                bestValue = std::max(bestValue, value);
-                alpha = std::max(alpha, bestValue);
+                auto bound = value;
+                value =
+                    alphaBeta(worker, state, alpha, beta, depth - 1, 1, !isMax);
+                if (isTimeUp())
+                    value = bound;
             }
-            else
-            {
-                bestValue = std::min(bestValue, value);
-                beta = std::min(beta, bestValue);
-            }
-            if (alpha >= beta)
-                break;
         }
-
-        // We only save the result if we didn't run out of time,
-        // since it means we were able to search the full depth.
-        if (!isTimeUp())
-        {
-            if (bestValue <= savedAlpha)
-                transpositionTable.emplace(
-                    state, bestValue, depth, Flag::upperBound);
-            else if (bestValue >= savedBeta)
-                transpositionTable.emplace(
-                    state, bestValue, depth, Flag::lowerBound);
-            else
-                transpositionTable.emplace(
-                    state, bestValue, depth, Flag::exact);
-        }
-
-        return bestValue;
-    }
-
-    std::vector<ActionType> heuristicSort(
-        std::vector<ActionType>& actions,
-        const StateType& state,
-        std::function<bool(EvalType, EvalType)> comp) const
-    {
-        std::map<ActionType, EvalType> values;
-        for (const auto& action : actions)
-            values[action] = heuristic(game.getResult(state, action));
-        return heuristicSort(actions, comp, values);
-    }
-
-    std::vector<ActionType> heuristicSort(
-        std::vector<ActionType>& actions,
-        std::function<bool(EvalType, EvalType)> comp,
-        const std::map<ActionType, EvalType>& values) const
-    {
-        // It is very important that the sort is stable, since it ensures that
-        // actions keep their relative ordering from previous sorts should they
-        // now be equal.
-        std::stable_sort(
-            std::begin(actions),
-            std::end(actions),
-            [&](const ActionType& lhs, const ActionType& rhs) {
-                return comp(values.find(lhs)->second, values.find(rhs)->second);
-            });
-        return actions;
-    }
-
-    bool isTimeUp() const
-    {
-        auto now = std::chrono::high_resolution_clock::now();
-        auto timeInMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-                            now - startTime)
-                            .count();
-        return timeInMs >= timeLimitInMs;
+        worker.path.pop_back();
+        game.unmakeMove(state, action);
+        return isProven;
     }
 };
 }
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <limits>
+
+namespace Search {
+
+// The limits of a search. By default, the search goes on until it is stopped.
+struct Limits
+{
+    // The time after which no new iteration is started, and the time by
+    // which the search must end.
+    int targetTimeInMs{std::numeric_limits<int>::max()};
+    int timeLimitInMs{std::numeric_limits<int>::max()};
+    // The depth after which no new iteration is started.
+    int depth{std::numeric_limits<int>::max()};
+    // The number of nodes after which the search ends. The nodes of all the
+    // threads of the search count.
+    long long nodes{std::numeric_limits<long long>::max()};
+};
+}
@@ -13,13 +13,18 @@ namespace Search {
 //      StateType - The type of the state representation for a position.
 //      ActionType - The type of an action in the game.
 //      EvalType - The type of a numerical position evaluation.
+//      ActionListType - The type of a list of actions, with random access
+//          iterators, such as std::vector<ActionType>.
 //
-//      std::vector<ActionType> getActions(StateType)
-//          A method to get a vector with the possible actions
+//      ActionListType getActions(StateType)
+//          A method to get a list with the possible actions
 //          that can be taken from a given state.
 //
-//      StateType getResult(StateType, ActionType)
-//          A method to apply an action to a state and get the next state.
+//      void makeMove(StateType&, ActionType)
+//          A method to apply an action to a state in place.
+//
+//      void unmakeMove(StateType&, ActionType)
+//          A method to undo an action applied to a state with makeMove.
 //
 //      bool isTerminal(StateType)
 //          A method to check if a state is terminal.
@@ -41,7 +46,7 @@ public:
     }
 
     ActionType search(
-        const StateType& state, Heuristic heuristic, int depth, bool isMax)
+        StateType state, Heuristic heuristic, int depth, bool isMax)
     {
         count = 1;
         this->heuristic = heuristic;
@@ -58,8 +63,9 @@ public:
         auto bestAction = std::make_pair(actions.front(), init);
         for (const auto& action : actions)
         {
-            auto value =
-                minimax(game.getResult(state, action), depth - 1, !isMax);
+            game.makeMove(state, action);
+            auto value = minimax(state, depth - 1, !isMax);
+            game.unmakeMove(state, action);
             if (comp(value, bestAction.second))
                 bestAction = std::make_pair(action, value);
         }
@@ -67,7 +73,7 @@ public:
         return bestAction.first;
     }
 
-    int getLastCount() const
+    long long getLastCount() const
     {
         return count;
     }
@@ -80,10 +86,10 @@ public:
 private:
     Game& game;
     int depth{};
-    int count{0};
+    long long count{0};
     Heuristic heuristic;
 
-    EvalType minimax(const StateType& state, int depth, bool isMax)
+    EvalType minimax(StateType& state, int depth, bool isMax)
     {
         ++count;
         if (game.isTerminal(state))
@@ -102,8 +108,9 @@ private:
         auto bestValue = init;
         for (const auto& action : game.getActions(state))
         {
-            auto value =
-                minimax(game.getResult(state, action), depth - 1, !isMax);
+            game.makeMove(state, action);
+            auto value = minimax(state, depth - 1, !isMax);
+            game.unmakeMove(state, action);
             if (comp(value, bestValue))
                 bestValue = value;
         }
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+#include "search/options.h"
+#include "search/limits.h"
+#include "search/search-base.h"
+
+namespace Search {
+
+// A class implementing the MTD(f) search algorithm for a game of type Game.
+// Within an iterative depth search, the value of the root at each depth is
+// found by a series of null window alpha-beta searches, each of which only
+// tells whether the value is above or below a guess. The guess starts at the
+// value found two plies before and moves to the bound returned by the last
+// search until the bounds meet. The searches revisit the same nodes many
+// times, which the transposition table makes cheap, since it keeps the bounds
+// and best actions found by the previous searches.
+//
+// The nodes below the root are searched by SearchBase, as in
+// IterativeAlphaBeta, without late move reductions and futility pruning, which
+// would make the null window searches inexact. The time is managed as in
+// IterativeAlphaBeta. The search runs on a single thread, which is its main
+// thread, and it has the same interface, so it can be run by an Engine.
+//
+// Game must define the same types and methods as for IterativeAlphaBeta.
+template <typename Game>
+class MTDf : public SearchBase<Game>
+{
+    using Base = SearchBase<Game>;
+
+public:
+    using typename Base::StateType;
+    using typename Base::ActionType;
+    using typename Base::EvalType;
+    using typename Base::Heuristic;
+
+    MTDf(Game& game, bool debug = false, const Options& options = Options{})
+        : Base{game, debug, getOptions(options)}
+    {
+    }
+
+    ActionType search(
+        const StateType& state,
+        Heuristic heuristic,
+        int timeLimitInMs,
+        bool isMax)
+    {
+        return search(
+            state, heuristic, Limits{timeLimitInMs, timeLimitInMs}, isMax);
+    }
+
+    ActionType search(
+        const StateType& state,
+        Heuristic heuristic,
+        const Limits& limits,
+        bool isMax)
+    {
+        if (!startSearch(state, heuristic, limits, 1))
+            return ActionType{};
+
+        StateType root = state;
+        auto result = iterate(workers.front(), root, isMax);
+        finishSearch(result);
+        return result.action;
+    }
+
+private:
+    using typename Base::ActionListType;
+    using typename Base::Worker;
+    using typename Base::Result;
+
+    using Base::maxPly;
+    using Base::noRepetition;
+    using Base::game;
+    using Base::transpositionTable;
+    using Base::workers;
+    using Base::hasher;
+    using Base::debug;
+    using Base::control;
+
+    using Base::startSearch;
+    using Base::finishSearch;
+    using Base::reportIteration;
+    using Base::alphaBeta;
+    using Base::storeRoot;
+    using Base::getNodeCount;
+    using Base::checkTime;
+    using Base::isTimeUp;
+
+    // Turns off the options that would make the null window searches inexact,
+    // and searches with a single thread.
+    static Options getOptions(Options options)
+    {
+        options.threads = 1;
+        options.lateMoveReductions = false;
+        options.futilityPruning = false;
+        return options;
+    }
+
+    Result iterate(Worker& worker, StateType& state, bool isMax)
+    {
+        auto actions = game.getActions(state);
+
+        auto winIndicator = isMax ? std::numeric_limits<EvalType>::max() :
+                                    std::numeric_limits<EvalType>::lowest();
+        auto lossIndicator = isMax ? std::numeric_limits<EvalType>::lowest() :
+                                     std::numeric_limits<EvalType>::max();
+
+        if (debug)
+        {
+            std::cerr << "========== actions ==========" << std::endl;
+        }
+
+        worker.path.push_back(hasher(state));
+
+        // The best action of the last complete iteration, its value, and the
+        // values of the last complete iterations of odd and even depths.
+        auto bestAction = actions.front();
+        auto bestValue = EvalType{};
+        EvalType parityValues[2]{};
+        for (int depth = 1;; ++depth)
+        {
+            if (depth > maxPly)
+            {
+                // Repetitions can make every line end in a draw, in which case
+                // the iterations would go on with no end.
+                return Result{bestAction, bestValue, depth - 1};
+            }
+
+            auto lower = std::numeric_limits<EvalType>::lowest();
+            auto upper = std::numeric_limits<EvalType>::max();
+            auto value = parityValues[depth % 2];
+            long long initialCount = worker.count;
+            worker.repetitionPly = noRepetition;
+            int passes = 0;
+            while (lower < upper && !checkTime(worker))
+            {
+                // Test whether the value is at least beta.
+                auto beta =
+                    value == lower ? std::nextafter(value, upper) : value;
+                auto alpha = std::nextafter(beta, lower);
+                size_t index = 0;
+                value = searchRoot(
+                    worker, state, actions, alpha, beta, depth, isMax, index);
+                ++passes;
+                if (value < beta)
+                    upper = value;
+                else
+                    lower = value;
+
+                // When the search proves an action to be better than the
+                // guess, it is the best action so far, so it goes first. This
+                // is kept even if the iteration runs out of time later on.
+                if (isMax == (value >= beta) && !isTimeUp())
+                {
+                    std::rotate(
+                        std::begin(actions),
+                        std::begin(actions) + index,
+                        std::begin(actions) + index + 1);
+                    if (value == winIndicator)
+                    {
+                        // We found our goal, so we can stop searching.
+                        return Result{actions.front(), value, depth};
+                    }
+                }
+            }
+
+            if (debug)
+            {
+                std::cerr << "searched " << getNodeCount()
+                          << " nodes so far at depth " << depth << " in "
+                          << passes << " passes with a table usage of "
+                          << transpositionTable.getUsage() << std::endl;
+            }
+
+            if (checkTime(worker))
+            {
+                // We ran out of time, so return the previous best action,
+                // unless this iteration proved another one better.
+                return Result{actions.front(), bestValue, depth - 1};
+            }
+
+            bestAction = actions.front();
+            bestValue = value;
+            parityValues[depth % 2] = value;
+            storeRoot(worker, state, value, depth, bestAction);
+            reportIteration(bestAction, value, depth);
+
+            if (debug)
+            {
+                std::cerr << "depth " << depth << " => " << bestAction << ": "
+                          << value << std::endl;
+            }
+
+            if (value == lossIndicator)
+            {
+                // If we are guaranteed to lose, there is no point in searching
+                // any deeper.
+                return Result{bestAction, bestValue, depth};
+            }
+
+            if (!control.update(depth, worker.count - initialCount))
+                return Result{bestAction, bestValue, depth};
+        }
+    }
+
+    // Searches the actions of the root, and gives the index of the action of
+    // the value returned.
+    EvalType searchRoot(
+        Worker& worker,
+        StateType& state,
+        const ActionListType& actions,
+        EvalType alpha,
+        EvalType beta,
+        int depth,
+        bool isMax,
+        size_t& index)
+    {
+        auto bestValue = isMax ? std::numeric_limits<EvalType>::lowest() :
+                                 std::numeric_limits<EvalType>::max();
+        for (size_t i = 0; i < actions.size(); ++i)
+        {
+            game.makeMove(state, actions[i]);
+            worker.path.push_back(hasher(state));
+            auto value = alphaBeta(
+                worker, state, alpha, beta, depth - 1, 1, !isMax);
+            worker.path.pop_back();
+            game.unmakeMove(state, actions[i]);
+            if (i == 0 || (isMax ? value > bestValue : value < bestValue))
+            {
+                bestValue = value;
+                index = i;
+            }
+            if (isMax)
+                alpha = std::max(alpha, bestValue);
+            else
+                beta = std::min(beta, bestValue);
+            if (alpha >= beta)
+                break;
+        }
+        return bestValue;
+    }
+};
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+namespace Search {
+
+// The ways to order the actions at the interior nodes of the search.
+enum class Ordering
+{
+    // Sort the actions by the heuristic value of their results. This costs a
+    // heuristic evaluation per action, so it is only done far from the leaves.
+    heuristic,
+    // Try the killer actions of the ply first, then the others by how often
+    // they produced cutoffs so far (history heuristic). This costs almost
+    // nothing, so it is done at every node.
+    history
+};
+
+// The settings of the iterative search engines.
+struct Options
+{
+    // The number of threads to search with. All threads share the same
+    // transposition table, and only the first one decides the action (lazy
+    // SMP).
+    int threads{1};
+
+    // The size of the transposition table in megabytes.
+    int hashSizeInMb{64};
+
+    // The ordering of the actions at the interior nodes of the search.
+    Ordering ordering{Ordering::history};
+
+    // Whether to search the actions after the first with a null window
+    // (principal variation search).
+    bool principalVariation{true};
+
+    // Whether to search each depth within a window around the value found two
+    // plies before, and the half-width of the window. The value of the
+    // previous depth is not used, since the values alternate between odd and
+    // even depths.
+    bool aspirationWindows{true};
+    double aspirationWindow{0.5};
+
+    // Whether to first search the actions ordered late with a reduced depth
+    // (late move reductions). An action that turns out to be better than the
+    // best so far is searched again at the full depth.
+    bool lateMoveReductions{true};
+
+    // Whether to only search the winning actions of the nodes near the leaves
+    // whose heuristic value is too far outside of the window (futility
+    // pruning), and the margin per ply of depth for which it is too far.
+    bool futilityPruning{false};
+    double futilityMargin{1.0};
+
+    // Whether to score a position that repeats on the path from the root or
+    // in the game as a draw, which only holds under rules that end the game
+    // on a repetition, as those of the games played locally do.
+    bool repetitionDraws{true};
+};
+}
@@ -1,12 +1,12 @@
 #pragma once
 
-#include <map>
-#include <vector>
 #include <limits>
 #include <algorithm>
 #include <utility>
 #include <functional>
 
+#include "util/static-vector.h"
+
 namespace Search {
 
 // A class implementing an ordered version of the alpha-beta search algorithm
@@ -17,13 +17,18 @@ namespace Search {
 //      StateType - The type of the state representation for a position.
 //      ActionType - The type of an action in the game.
 //      EvalType - The type of a numerical position evaluation.
+//      ActionListType - The type of a list of actions, with random access
+//          and a static capacity(), such as Util::StaticVector<ActionType, N>.
 //
-//      std::vector<ActionType> getActions(StateType)
-//          A method to get a vector with the possible actions
+//      ActionListType getActions(StateType)
+//          A method to get a list with the possible actions
 //          that can be taken from a given state.
 //
-//      StateType getResult(StateType, ActionType)
-//          A method to apply an action to a state and get the next state.
+//      void makeMove(StateType&, ActionType)
+//          A method to apply an action to a state in place.
+//
+//      void unmakeMove(StateType&, ActionType)
+//          A method to undo an action applied to a state with makeMove.
 //
 //      bool isTerminal(StateType)
 //          A method to check if a state is terminal.
@@ -37,6 +42,7 @@ public:
     using StateType = typename Game::StateType;
     using ActionType = typename Game::ActionType;
     using EvalType = typename Game::EvalType;
+    using ActionListType = typename Game::ActionListType;
 
     using Heuristic = std::function<EvalType(const StateType&)>;
 
@@ -45,7 +51,7 @@ public:
     }
 
     ActionType search(
-        const StateType& state, Heuristic heuristic, int depth, bool isMax)
+        StateType state, Heuristic heuristic, int depth, bool isMax)
     {
         count = 1;
         this->heuristic = heuristic;
@@ -65,12 +71,13 @@ public:
         // Sorting the actions using the heuristic helps us consider
         // the best actions first.
         if (depth > 1)
-            actions = heuristicSort(actions, state, comp);
+            heuristicSort(actions, state, comp);
         auto bestAction = std::make_pair(actions.front(), init);
         for (const auto& action : actions)
         {
-            auto value = alphaBeta(
-                game.getResult(state, action), alpha, beta, depth - 1, !isMax);
+            game.makeMove(state, action);
+            auto value = alphaBeta(state, alpha, beta, depth - 1, !isMax);
+            game.unmakeMove(state, action);
             if (isMax)
             {
                 alpha = std::max(alpha, value);
@@ -90,7 +97,7 @@ public:
         return bestAction.first;
     }
 
-    int getLastCount() const
+    long long getLastCount() const
     {
         return count;
     }
@@ -101,13 +108,16 @@ public:
     }
 
 private:
+    using ValueListType =
+        Util::StaticVector<EvalType, ActionListType::capacity()>;
+
     Game& game;
     int depth{};
-    int count{0};
+    long long count{0};
     Heuristic heuristic;
 
     EvalType alphaBeta(
-        const StateType& state,
+        StateType& state,
         EvalType alpha,
         EvalType beta,
         int depth,
@@ -132,11 +142,12 @@ private:
         // Sorting the actions using the heuristic helps us consider
         // the best actions first.
         if (depth > 1)
-            actions = heuristicSort(actions, state, comp);
+            heuristicSort(actions, state, comp);
         for (const auto& action : actions)
         {
-            auto value = alphaBeta(
-                game.getResult(state, action), alpha, beta, depth - 1, !isMax);
+            game.makeMove(state, action);
+            auto value = alphaBeta(state, alpha, beta, depth - 1, !isMax);
+            game.unmakeMove(state, action);
             if (isMax)
             {
                 bestValue = std::max(bestValue, value);
@@ -153,32 +164,44 @@ private:
         return bestValue;
     }
 
-    std::vector<ActionType> heuristicSort(
-        std::vector<ActionType>& actions,
-        const StateType& state,
+    void heuristicSort(
+        ActionListType& actions,
+        StateType& state,
         std::function<bool(EvalType, EvalType)> comp) const
     {
-        std::map<ActionType, EvalType> values;
+        ValueListType values;
         for (const auto& action : actions)
-            values[action] = heuristic(game.getResult(state, action));
-        return heuristicSort(actions, comp, values);
+        {
+            game.makeMove(state, action);
+            values.push_back(heuristic(state));
+            game.unmakeMove(state, action);
+        }
+        heuristicSort(actions, comp, values);
     }
 
-    std::vector<ActionType> heuristicSort(
-        std::vector<ActionType>& actions,
+    // Sorts the actions in place, along with their values.
+    void heuristicSort(
+        ActionListType& actions,
         std::function<bool(EvalType, EvalType)> comp,
-        const std::map<ActionType, EvalType>& values) const
+        ValueListType& values) const
     {
         // It is very important that the sort is stable, since it ensures that
         // actions keep their relative ordering from previous sorts should they
-        // now be equal.
-        std::stable_sort(
-            std::begin(actions),
-            std::end(actions),
-            [&](const ActionType& lhs, const ActionType& rhs) {
-                return comp(values.find(lhs)->second, values.find(rhs)->second);
-            });
-        return actions;
+        // now be equal. An insertion sort is stable, needs no extra memory, and
+        // is fast on lists this short.
+        for (size_t i = 1; i < actions.size(); ++i)
+        {
+            auto action = actions[i];
+            auto value = values[i];
+            auto j = i;
+            for (; j > 0 && comp(value, values[j - 1]); --j)
+            {
+                actions[j] = actions[j - 1];
+                values[j] = values[j - 1];
+            }
+            actions[j] = action;
+            values[j] = value;
+        }
     }
 };
 }
@@ -0,0 +1,668 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include <functional>
+#include <atomic>
+#include <mutex>
+
+#include "search/options.h"
+#include "search/limits.h"
+#include "search/search-control.h"
+#include "search/transposition-table.h"
+#include "util/static-vector.h"
+
+namespace Search {
+
+// A base class for the iterative searches of a game of type Game, such as
+// IterativeAlphaBeta and MTDf, which only differ in how they search the root.
+// It holds the transposition table, the control of the time, the progress
+// and the data of each thread of the search, and it implements the interface
+// the searches share, as well as the alpha-beta search of the nodes below the
+// root:
+//      1) The best action stored in the transposition table is searched
+//          first, and the other actions are sorted in the order chosen in the
+//          options (see IterativeAlphaBeta).
+//      2) The actions after the first are searched with a null window, and
+//          the ones ordered late with a reduced depth first, as chosen in the
+//          options.
+//      3) Near the leaves, the actions of a node whose heuristic value is far
+//          outside of the window are skipped unless they win, if chosen in
+//          the options.
+//      4) A position that repeats on the path from the root or in the game is
+//          scored as a draw, unless turned off in the options.
+//
+// Game must define the same types and methods as for IterativeAlphaBeta.
+template <typename Game>
+class SearchBase
+{
+public:
+    using StateType = typename Game::StateType;
+    using ActionType = typename Game::ActionType;
+    using EvalType = typename Game::EvalType;
+    using ActionListType = typename Game::ActionListType;
+
+    using Heuristic = std::function<EvalType(const StateType&)>;
+
+    using Progress = SearchProgress<Game>;
+
+    // A function called by the main thread after each complete iteration.
+    using Listener = std::function<void(const Progress&)>;
+
+    // Gives a search in progress, such as one pondering on the position
+    // expected after the move of the opponent, new limits, with the time
+    // counted from now. This may be called from any thread, and fails if no
+    // search is in progress.
+    bool ponderHit(const Limits& limits)
+    {
+        return control.ponderHit(limits);
+    }
+
+    // Sets a function to call after each complete iteration of the searches
+    // to come, or none if it is empty.
+    void setListener(Listener listener)
+    {
+        this->listener = listener;
+    }
+
+    // Gives the progress of the search in progress as of its last complete
+    // iteration, or the result of the last search. This may be called from
+    // any thread.
+    Progress getProgress() const
+    {
+        std::lock_guard<std::mutex> lock{progressMutex};
+        return progress;
+    }
+
+    // Gives the sequence of best actions from a state found by the last
+    // search, as far as the transposition table knows them.
+    std::vector<ActionType> getPrincipalVariation(
+        const StateType& state) const
+    {
+        return transpositionTable.getPrincipalVariation(game, state, maxPly);
+    }
+
+    // Waits for the transposition table to be ready, as the first search
+    // would otherwise compete with the background thread that prepares it.
+    void waitUntilReady()
+    {
+        transpositionTable.waitUntilReady();
+    }
+
+    // Sets the positions of the game before the state to search, which the
+    // search scores as draws should they occur again.
+    void setHistory(const std::vector<StateType>& history)
+    {
+        historyKeys.clear();
+        for (const auto& state : history)
+            historyKeys.push_back(hasher(state));
+        std::sort(std::begin(historyKeys), std::end(historyKeys));
+    }
+
+    // Stops the search in progress, which then returns its best action so
+    // far. This may be called from any thread.
+    void stop()
+    {
+        control.stop();
+    }
+
+    // Stops the search of an id given by getNextSearchId(), whether it is in
+    // progress or yet to start, in which case it returns as soon as it does.
+    // This may be called from any thread.
+    void stop(long long searchId)
+    {
+        control.stop(searchId);
+    }
+
+    // Gives the id of the next search, which a thread that starts it can use
+    // to stop it without knowing whether it has started.
+    long long getNextSearchId() const
+    {
+        return control.getNextSearchId();
+    }
+
+    long long getLastCount() const
+    {
+        return count;
+    }
+
+    int getLastDepth() const
+    {
+        return depth;
+    }
+
+protected:
+    using ValueListType =
+        Util::StaticVector<EvalType, ActionListType::capacity()>;
+
+    // The number of plies from the root for which killer moves are kept.
+    static const int maxPly = 128;
+    // The history scores are halved when one of them grows past this.
+    static const int maxHistory = 1 << 20;
+    // The number of nodes searched between readings of the clock.
+    static const int nodesPerTimeCheck = 1024;
+    // The ply of the earlier occurrence of a position that did not repeat.
+    static const int noRepetition = std::numeric_limits<int>::max();
+
+    // The data owned by each thread of the search.
+    struct Worker
+    {
+        int id{};
+        // The number of nodes searched, which the main thread reads while the
+        // thread of the worker writes it.
+        std::atomic<long long> count{0};
+        long long probes{0};
+        long long hits{0};
+        // The codes of the killer moves of each ply, or -1 if there are none.
+        std::array<std::array<int, 2>, maxPly> killers;
+        // The history score of each move for the max and min players.
+        std::array<std::array<int, Game::actionCodeCount>, 2> history{};
+        // The keys of the positions from the root to the current one.
+        std::vector<uint64_t> path;
+        // The least ply of the positions that the repetitions found since
+        // this was reset repeat, which is -1 for a position of the game before
+        // the root. The value of a node depends on its path when it depends on
+        // a repetition of a position before it.
+        int repetitionPly{noRepetition};
+
+        Worker()
+        {
+            for (auto& plyKillers : killers)
+                plyKillers.fill(-1);
+            path.reserve(maxPly + 1);
+        }
+
+        // Counts a node, and gives the number of nodes so far. Only the
+        // thread of the worker writes the count, so it needs no atomic
+        // increment.
+        long long addNode()
+        {
+            auto nodes = count.load(std::memory_order_relaxed) + 1;
+            count.store(nodes, std::memory_order_relaxed);
+            return nodes;
+        }
+    };
+
+    // The outcome of the iterative search of a thread.
+    struct Result
+    {
+        ActionType action;
+        EvalType value;
+        int depth;
+    };
+
+    Game& game;
+    long long count{0};
+    int depth{0};
+    Heuristic heuristic;
+
+    TranspositionTable<Game> transpositionTable;
+    // The data of each thread, the first of which is the main thread.
+    std::vector<Worker> workers;
+    std::hash<StateType> hasher;
+    // The keys of the positions of the game before the root, sorted.
+    std::vector<uint64_t> historyKeys;
+
+    SearchControl control;
+    // The progress may be read by any thread while the search runs.
+    mutable std::mutex progressMutex;
+    Progress progress;
+    Listener listener;
+
+    bool debug{};
+    Options options;
+
+    SearchBase(Game& game, bool debug, const Options& options)
+        : game(game),
+          transpositionTable{static_cast<size_t>(options.hashSizeInMb)},
+          debug{debug},
+          options(options)
+    {
+    }
+
+    // Prepares a search of a state within some limits with some threads, and
+    // tells whether there is anything to search. Without any action, there is
+    // nothing to search or to return, but the search still takes its id.
+    bool startSearch(
+        const StateType& state,
+        Heuristic heuristic,
+        const Limits& limits,
+        int threads)
+    {
+        this->heuristic = heuristic;
+        count = 1;
+        depth = 0;
+        {
+            std::lock_guard<std::mutex> lock{progressMutex};
+            progress = Progress{};
+            progress.count = count;
+        }
+        control.start(limits);
+        if (game.getActions(state).empty())
+        {
+            control.finish();
+            return false;
+        }
+        transpositionTable.newSearch();
+
+        workers = std::vector<Worker>(std::max(threads, 1));
+        for (size_t i = 0; i < workers.size(); ++i)
+            workers[i].id = i;
+        return true;
+    }
+
+    // Ends the search, once all of its threads are done, with the result of
+    // the main thread.
+    void finishSearch(const Result& result)
+    {
+        control.finish();
+        count = getNodeCount();
+        depth = result.depth;
+        std::lock_guard<std::mutex> lock{progressMutex};
+        progress = Progress{result.action, result.value, result.depth, count};
+    }
+
+    // Records a complete iteration of the main thread, and tells the
+    // listener about it.
+    void reportIteration(const ActionType& action, EvalType value, int depth)
+    {
+        {
+            std::lock_guard<std::mutex> lock{progressMutex};
+            progress = Progress{action, value, depth, getNodeCount()};
+        }
+        if (listener)
+            listener(getProgress());
+    }
+
+    EvalType alphaBeta(
+        Worker& worker,
+        StateType& state,
+        EvalType alpha,
+        EvalType beta,
+        int depth,
+        int ply,
+        bool isMax)
+    {
+        // Reading the clock at every node would be costly, so only the main
+        // thread reads it, every few nodes.
+        auto nodes = worker.addNode();
+        if (worker.id == 0 && nodes % nodesPerTimeCheck == 0)
+        {
+            control.checkLimits(getNodeCount());
+        }
+        if (game.isTerminal(state))
+            return game.getUtility(state);
+        else if (options.repetitionDraws && isRepetition(worker))
+            return game.getDrawUtility();
+        else if (depth == 0 || isTimeUp())
+            return heuristic(state);
+
+        auto entry = transpositionTable.find(state);
+        ++worker.probes;
+        if (entry.first)
+            ++worker.hits;
+        // Wins and losses from earlier searches are not used for cutoffs. If
+        // we are guaranteed to lose, we want to recompute the path to the most
+        // distant loss in case we are playing against a non-optimal player or
+        // an optimal player with restricted search depth, and a stored loss
+        // would end the iterative search before it gets there.
+        if (entry.first && entry.second.depth >= depth &&
+            !(entry.second.isStale && isDecisive(entry.second.value)))
+        {
+            auto value = entry.second.value;
+            auto flag = entry.second.flag;
+            if (flag == Flag::exact)
+                return value;
+            else if (flag == Flag::lowerBound && value >= beta)
+                return value;
+            else if (flag == Flag::upperBound && value <= alpha)
+                return value;
+        }
+        auto savedAlpha = alpha, savedBeta = beta;
+        auto parentRepetitionPly = worker.repetitionPly;
+
+        auto init = isMax ? std::numeric_limits<EvalType>::lowest() :
+                            std::numeric_limits<EvalType>::max();
+        std::function<bool(EvalType, EvalType)> comp;
+        if (isMax)
+            comp = std::greater<EvalType>{};
+        else
+            comp = std::less<EvalType>{};
+
+        // Near the leaves, if the heuristic value of the state is too far
+        // outside of the window for the remaining plies to make up for, only
+        // the winning actions are searched, and the others are assumed to be
+        // worth the heuristic value plus the margin. This is only done in null
+        // window searches, where the exact value is not needed.
+        bool isFutile = false;
+        auto futilityValue = init;
+        if (options.futilityPruning && depth <= 2 &&
+            std::nextafter(alpha, beta) == beta)
+        {
+            auto margin = static_cast<EvalType>(options.futilityMargin * depth);
+            auto value = heuristic(state);
+            futilityValue = isMax ? value + margin : value - margin;
+            isFutile = isMax ? futilityValue <= alpha : futilityValue >= beta;
+        }
+
+        auto bestValue = init;
+        ActionType bestAction{};
+        bool hasBestAction = false;
+        // The repetitions the value of the best action, and those of all the
+        // actions, depend on.
+        auto bestRepetitionPly = noRepetition;
+        auto anyRepetitionPly = noRepetition;
+        int actionCount = 0;
+        auto searchAction = [&](const ActionType& action) {
+            // The actions after the first few are searched with a reduced
+            // depth first, by two plies for the last ones of deep nodes.
+            auto reduction = 0;
+            if (options.lateMoveReductions && depth >= 3 && actionCount >= 3)
+                reduction = actionCount >= 8 && depth >= 5 ? 2 : 1;
+            ++actionCount;
+
+            game.makeMove(state, action);
+            worker.path.push_back(hasher(state));
+            worker.repetitionPly = noRepetition;
+            auto value = searchChild(
+                worker, state, alpha, beta, depth - 1, ply + 1, !isMax,
+                !hasBestAction, reduction);
+            worker.path.pop_back();
+            game.unmakeMove(state, action);
+            if (!hasBestAction || comp(value, bestValue))
+            {
+                bestValue = value;
+                bestAction = action;
+                hasBestAction = true;
+                bestRepetitionPly = worker.repetitionPly;
+            }
+            anyRepetitionPly = std::min(anyRepetitionPly, worker.repetitionPly);
+            if (isMax)
+                alpha = std::max(alpha, bestValue);
+            else
+                beta = std::min(beta, bestValue);
+        };
+
+        // The best action stored in the table is searched first, and if it
+        // gives a cutoff, the other actions need not even be generated. The
+        // action is checked since different states may share an entry.
+        auto hasHashAction = entry.first && entry.second.hasAction &&
+            game.isLegal(state, entry.second.action);
+        if (hasHashAction)
+            searchAction(entry.second.action);
+
+        if (alpha < beta)
+        {
+            auto actions = game.getActions(state);
+            // Sorting the actions helps us consider the best actions first.
+            if (options.ordering == Ordering::history)
+                historySort(worker, actions, ply, isMax);
+            else if (depth >= 4)
+                heuristicSort(actions, state, comp);
+            for (const auto& action : actions)
+            {
+                if (hasHashAction && action == entry.second.action)
+                    continue;
+                if (isFutile && !isWinning(state, action))
+                    continue;
+                searchAction(action);
+                if (alpha >= beta)
+                    break;
+            }
+        }
+        if (isFutile)
+            bestValue = isMax ? std::max(bestValue, futilityValue) :
+                                std::min(bestValue, futilityValue);
+
+        if (alpha >= beta && hasBestAction)
+            updateHistory(worker, bestAction, depth, ply, isMax);
+
+        // A cutoff only depends on the repetitions of the action that produced
+        // it, but another value depends on those of all the actions searched,
+        // which bound it.
+        auto isCutoff =
+            isMax ? bestValue >= savedBeta : bestValue <= savedAlpha;
+        auto repetitionPly = isCutoff ? bestRepetitionPly : anyRepetitionPly;
+        worker.repetitionPly = std::min(parentRepetitionPly, repetitionPly);
+
+        // We only save the result if we didn't run out of time,
+        // since it means we were able to search the full depth.
+        // The best action is only kept for exact values and cutoffs, since
+        // when all actions fail low, the best one is not known.
+        // A value scored from a repetition of a position before this one need
+        // not hold when this one is reached by another path, so it is not
+        // saved either.
+        if (!isTimeUp() && repetitionPly >= ply)
+        {
+            if (bestValue <= savedAlpha)
+                store(state, bestValue, depth, Flag::upperBound,
+                      !isMax && hasBestAction, bestAction);
+            else if (bestValue >= savedBeta)
+                store(state, bestValue, depth, Flag::lowerBound,
+                      isMax && hasBestAction, bestAction);
+            else
+                store(state, bestValue, depth, Flag::exact,
+                      hasBestAction, bestAction);
+        }
+
+        return bestValue;
+    }
+
+    void store(
+        const StateType& state,
+        EvalType value,
+        int depth,
+        Flag flag,
+        bool hasAction,
+        const ActionType& action)
+    {
+        if (hasAction)
+            transpositionTable.emplace(state, value, depth, flag, action);
+        else
+            transpositionTable.emplace(state, value, depth, flag);
+    }
+
+    // Stores the best action of the root after an iteration, so that the
+    // principal variation can be followed from it. A value that depends on a
+    // repetition of a position of the game before the root is stored at depth
+    // 0, for which the table never gives a cutoff.
+    void storeRoot(
+        const Worker& worker,
+        const StateType& state,
+        EvalType value,
+        int depth,
+        const ActionType& action)
+    {
+        if (worker.repetitionPly < 0)
+            depth = 0;
+        transpositionTable.emplace(state, value, depth, Flag::exact, action);
+    }
+
+    // Searches a child node, where the first child of a node is searched with
+    // the full window, and the others with a null window first, at a reduced
+    // depth if they were ordered late.
+    EvalType searchChild(
+        Worker& worker,
+        StateType& state,
+        EvalType alpha,
+        EvalType beta,
+        int depth,
+        int ply,
+        bool isMax,
+        bool isFirst,
+        int reduction)
+    {
+        if (isFirst)
+            return alphaBeta(worker, state, alpha, beta, depth, ply, isMax);
+
+        // The parent is a max node if the child is a min node, in which case
+        // we try to prove that the child is worth at most alpha, and otherwise
+        // that it is worth at least beta. If this fails, the child is better
+        // than the best so far, and we need its exact value.
+        auto nullAlpha = isMax ? std::nextafter(beta, alpha) : alpha;
+        auto nullBeta = isMax ? beta : std::nextafter(alpha, beta);
+        if (reduction > 0)
+        {
+            auto value = alphaBeta(
+                worker, state, nullAlpha, nullBeta, depth - reduction, ply,
+                isMax);
+            if (isMax ? value >= beta : value <= alpha)
+                return value;
+        }
+
+        if (!options.principalVariation)
+            return alphaBeta(worker, state, alpha, beta, depth, ply, isMax);
+        auto value =
+            alphaBeta(worker, state, nullAlpha, nullBeta, depth, ply, isMax);
+        if (value > alpha && value < beta)
+            value = alphaBeta(worker, state, alpha, beta, depth, ply, isMax);
+        return value;
+    }
+
+    // Sorts the actions with the killer moves of the ply first, then the
+    // others by their history scores.
+    void historySort(
+        const Worker& worker,
+        ActionListType& actions,
+        int ply,
+        bool isMax) const
+    {
+        const auto& history = worker.history[isMax ? 0 : 1];
+        ValueListType values;
+        for (const auto& action : actions)
+        {
+            auto code = Game::getActionCode(action);
+            if (ply < maxPly && code == worker.killers[ply][0])
+                values.push_back(maxHistory + 2);
+            else if (ply < maxPly && code == worker.killers[ply][1])
+                values.push_back(maxHistory + 1);
+            else
+                values.push_back(history[code]);
+        }
+        heuristicSort(actions, std::greater<EvalType>{}, values);
+    }
+
+    // Records an action that produced a cutoff.
+    void updateHistory(
+        Worker& worker,
+        const ActionType& action,
+        int depth,
+        int ply,
+        bool isMax) const
+    {
+        auto code = Game::getActionCode(action);
+        if (ply < maxPly && worker.killers[ply][0] != code)
+        {
+            worker.killers[ply][1] = worker.killers[ply][0];
+            worker.killers[ply][0] = code;
+        }
+
+        auto& history = worker.history[isMax ? 0 : 1];
+        history[code] += depth * depth;
+        if (history[code] > maxHistory)
+            for (auto& score : history)
+                score /= 2;
+    }
+
+    void heuristicSort(
+        ActionListType& actions,
+        StateType& state,
+        std::function<bool(EvalType, EvalType)> comp) const
+    {
+        ValueListType values;
+        for (const auto& action : actions)
+        {
+            game.makeMove(state, action);
+            values.push_back(heuristic(state));
+            game.unmakeMove(state, action);
+        }
+        heuristicSort(actions, comp, values);
+    }
+
+    // Sorts the actions in place, along with their values.
+    void heuristicSort(
+        ActionListType& actions,
+        std::function<bool(EvalType, EvalType)> comp,
+        ValueListType& values) const
+    {
+        // It is very important that the sort is stable, since it ensures that
+        // actions keep their relative ordering from previous sorts should they
+        // now be equal. An insertion sort is stable, needs no extra memory, and
+        // is fast on lists this short.
+        for (size_t i = 1; i < actions.size(); ++i)
+        {
+            auto action = actions[i];
+            auto value = values[i];
+            auto j = i;
+            for (; j > 0 && comp(value, values[j - 1]); --j)
+            {
+                actions[j] = actions[j - 1];
+                values[j] = values[j - 1];
+            }
+            actions[j] = action;
+            values[j] = value;
+        }
+    }
+
+    // Checks if the current position occurred before, on the path from the
+    // root or in the game, and records the ply where it did.
+    bool isRepetition(Worker& worker) const
+    {
+        // A position can only occur again with the same player to move, and
+        // it takes at least four plies for the pieces to move back. The ply of
+        // a position on the path is its index.
+        const auto& path = worker.path;
+        auto key = path.back();
+        auto ply = noRepetition;
+        for (int i = static_cast<int>(path.size()) - 5; i >= 0; i -= 2)
+            if (path[i] == key)
+                ply = i;
+        if (ply == noRepetition &&
+            std::binary_search(
+                std::begin(historyKeys), std::end(historyKeys), key))
+            ply = -1;
+        worker.repetitionPly = std::min(worker.repetitionPly, ply);
+        return ply != noRepetition;
+    }
+
+    bool isWinning(StateType& state, const ActionType& action) const
+    {
+        game.makeMove(state, action);
+        auto result = game.isTerminal(state);
+        game.unmakeMove(state, action);
+        return result;
+    }
+
+    static bool isDecisive(EvalType value)
+    {
+        return value == std::numeric_limits<EvalType>::max() ||
+            value == std::numeric_limits<EvalType>::lowest();
+    }
+
+    // Gives the number of nodes searched by all the threads so far, counting
+    // the root.
+    long long getNodeCount() const
+    {
+        long long nodes = 1;
+        for (const auto& worker : workers)
+            nodes += worker.count.load(std::memory_order_relaxed);
+        return nodes;
+    }
+
+    // Tells whether the search should stop. Only the main thread reads the
+    // clock, so the helpers only read the flag it sets.
+    bool checkTime(const Worker& worker)
+    {
+        return worker.id == 0 ? control.checkTime() : control.isTimeUp();
+    }
+
+    bool isTimeUp() const
+    {
+        return control.isTimeUp();
+    }
+};
+}
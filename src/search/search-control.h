@@ -0,0 +1,153 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+#include "search/limits.h"
+#include "search/time-manager.h"
+
+namespace Search {
+
+// The best action found by a search of a game of type Game, its value, the
+// depth to which it was searched, which is 0 until the first iteration is
+// complete, and the number of nodes searched by all its threads to get there.
+template <typename Game>
+struct SearchProgress
+{
+    typename Game::ActionType action{};
+    typename Game::EvalType value{};
+    int depth{0};
+    long long count{0};
+};
+
+// A class telling the threads of an iterative search when to stop. The search
+// stops when the flag is set, either by stop() or once the main thread finds
+// that the deadline has passed or that it searched as many nodes as it may.
+// The limits may be moved by ponderHit() while the search runs, so the time
+// manager is guarded by a mutex.
+//
+// Each search takes the next id when it starts. A search can be stopped by
+// its id before it starts, from another thread that cannot tell whether it
+// has, in which case it starts stopped. A stop of an earlier search has no
+// effect on the next one.
+//
+// Only the main thread of the search reads the clock, with checkTime() or
+// checkLimits(). The other threads only read the flag, with isTimeUp().
+class SearchControl
+{
+public:
+    // Starts timing a new search within some limits.
+    void start(const Limits& limits)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        ++searchId;
+        timeManager.start(limits.targetTimeInMs, limits.timeLimitInMs);
+        setLimits(limits);
+        isStopped = stoppedId >= searchId;
+        isSearching = true;
+    }
+
+    // Gives the id of the next search to start.
+    long long getNextSearchId() const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return searchId + 1;
+    }
+
+    // Ends the search, once all of its threads are done.
+    void finish()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        isSearching = false;
+    }
+
+    // Gives the search in progress new limits, with the time counted from
+    // now. This may be called from any thread, and fails if no search is in
+    // progress.
+    bool ponderHit(const Limits& limits)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (!isSearching)
+            return false;
+        timeManager.restart(limits.targetTimeInMs, limits.timeLimitInMs);
+        setLimits(limits);
+        return true;
+    }
+
+    // Stops the search in progress. This may be called from any thread.
+    void stop()
+    {
+        isStopped = true;
+    }
+
+    // Stops the search of an id, whether it is in progress or yet to start.
+    // This may be called from any thread.
+    void stop(long long id)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stoppedId = std::max(stoppedId, id);
+        if (isSearching && searchId == id)
+            isStopped = true;
+    }
+
+    // Records a complete iteration to some depth, with the number of nodes it
+    // searched, and tells whether the next one should be started.
+    bool update(int depth, long long iterationNodes)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        timeManager.update(iterationNodes);
+        return depth < maxDepth && timeManager.canIterate();
+    }
+
+    double getBranchingFactor() const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return timeManager.getBranchingFactor();
+    }
+
+    // Reads the clock, and stops the search if the deadline has passed.
+    bool checkTime()
+    {
+        if (std::chrono::steady_clock::now() >=
+            deadline.load(std::memory_order_relaxed))
+            isStopped = true;
+        return isTimeUp();
+    }
+
+    // Checks the time, and stops the search if the main thread searched as
+    // many nodes as it may.
+    void checkLimits(long long count)
+    {
+        checkTime();
+        if (count >= maxNodes.load(std::memory_order_relaxed))
+            stop();
+    }
+
+    bool isTimeUp() const
+    {
+        return isStopped.load(std::memory_order_relaxed);
+    }
+
+private:
+    TimeManager timeManager;
+    mutable std::mutex mutex;
+    bool isSearching{false};
+    // The id of the current or last search, and the last one to be stopped
+    // by its id.
+    long long searchId{0};
+    long long stoppedId{0};
+    int maxDepth{};
+    std::atomic<long long> maxNodes{};
+    std::atomic<std::chrono::steady_clock::time_point> deadline;
+    std::atomic<bool> isStopped{false};
+
+    void setLimits(const Limits& limits)
+    {
+        deadline = timeManager.getDeadline();
+        maxDepth = limits.depth;
+        maxNodes = limits.nodes;
+    }
+};
+}
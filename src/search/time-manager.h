@@ -0,0 +1,173 @@
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+
+#include "search/limits.h"
+
+namespace Search {
+
+// A class deciding when an iterative search should stop. The search is given
+// a target time, after which it starts no new iteration, and a time limit, by
+// which it must be done. The time of the next iteration is predicted from the
+// time of the last one and the effective branching factor of the previous
+// ones, and an iteration that would not complete by the limit is not started,
+// since the results of an incomplete iteration are mostly thrown away.
+class TimeManager
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Starts timing a new search.
+    void start(int targetTimeInMs, int timeLimitInMs)
+    {
+        startTime = Clock::now();
+        lastTime = startTime;
+        target = std::chrono::milliseconds{targetTimeInMs};
+        limit = std::chrono::milliseconds{timeLimitInMs};
+        nodes.clear();
+        times.clear();
+    }
+
+    // Starts the time over for a search under way, keeping the record of its
+    // iterations, such as when the position it pondered on comes up.
+    void restart(int targetTimeInMs, int timeLimitInMs)
+    {
+        startTime = Clock::now();
+        target = std::chrono::milliseconds{targetTimeInMs};
+        limit = std::chrono::milliseconds{timeLimitInMs};
+    }
+
+    Clock::time_point getDeadline() const
+    {
+        return startTime + limit;
+    }
+
+    // Records a completed iteration, with the number of nodes it searched.
+    void update(long long iterationNodes)
+    {
+        auto now = Clock::now();
+        nodes.push_back(std::max(iterationNodes, 1ll));
+        times.push_back(now - lastTime);
+        lastTime = now;
+    }
+
+    // Gives the factor by which the number of nodes grows with each ply,
+    // or 0 until there are two iterations to compare. The values of odd and
+    // even depths alternate, and so do the sizes of their trees, so the
+    // factor is measured over two plies when it can be.
+    double getBranchingFactor() const
+    {
+        auto size = nodes.size();
+        if (size >= 3)
+            return std::sqrt(
+                static_cast<double>(nodes[size - 1]) / nodes[size - 3]);
+        else if (size == 2)
+            return static_cast<double>(nodes[1]) / nodes[0];
+        return 0;
+    }
+
+    // Checks if the next iteration should be started, which it should not
+    // once the target time has passed, or if it is predicted to end after
+    // the time limit.
+    bool canIterate() const
+    {
+        auto elapsed = Clock::now() - startTime;
+        if (elapsed >= target)
+            return false;
+        if (times.empty())
+            return true;
+        auto factor = std::max(getBranchingFactor(), 1.0);
+        auto predicted = std::chrono::duration_cast<Clock::duration>(
+            times.back() * factor);
+        return elapsed + predicted < limit;
+    }
+
+private:
+    Clock::time_point startTime;
+    Clock::time_point lastTime;
+    Clock::duration target{};
+    Clock::duration limit{};
+    // The number of nodes and time of each completed iteration.
+    std::vector<long long> nodes;
+    std::vector<Clock::duration> times;
+};
+
+// A class dividing a budget of time for a whole game between its moves. Each
+// move aims for an even share of the time left over the moves expected to
+// remain, and may take up to three times as much when its search needs it, so
+// that the time saved on easy moves goes to the hard ones. No move may take
+// longer than the time limit per move. Without a budget, every move gets the
+// time limit per move.
+//
+// No move may take longer than the time left minus a fixed overhead, which
+// covers the time a move takes beyond its search. Within that, each move gets
+// at least a few milliseconds, so that its search can complete its first
+// iteration. Once the budget runs out, a move gets no time at all, and plays
+// the first legal action unsearched rather than overrun the budget further.
+class GameClock
+{
+public:
+    GameClock(int moveTimeLimitInMs, int budgetInMs = 0)
+        : moveTimeLimitInMs{moveTimeLimitInMs},
+          remainingInMs{budgetInMs},
+          hasBudget{budgetInMs > 0}
+    {
+    }
+
+    int getTargetTimeInMs() const
+    {
+        if (!hasBudget)
+            return moveTimeLimitInMs;
+        auto movesToGo = std::max(expectedMoves - moves, minMovesToGo);
+        return std::min(
+            std::max(remainingInMs / movesToGo, minTimeInMs),
+            getMaxTimeInMs());
+    }
+
+    int getTimeLimitInMs() const
+    {
+        if (!hasBudget)
+            return moveTimeLimitInMs;
+        return std::min(3 * getTargetTimeInMs(), getMaxTimeInMs());
+    }
+
+    Limits getLimits() const
+    {
+        return Limits{getTargetTimeInMs(), getTimeLimitInMs()};
+    }
+
+    // Records a move of ours that took the given time.
+    void update(int timeInMs)
+    {
+        ++moves;
+        if (hasBudget)
+            remainingInMs -= timeInMs;
+    }
+
+private:
+    // The number of moves a player is expected to make in a game, and the
+    // least number of moves the time left is divided between.
+    static const int expectedMoves = 40;
+    static const int minMovesToGo = 10;
+    // The least time given to a move, if there is that much left.
+    static const int minTimeInMs = 10;
+    // The time a move takes beyond its search, such as to send the action.
+    static const int overheadInMs = 50;
+
+    int moveTimeLimitInMs{};
+    // The time left, which is negative once the budget is overrun.
+    int remainingInMs{};
+    bool hasBudget{};
+    int moves{0};
+
+    // Gives the most time the next move may take.
+    int getMaxTimeInMs() const
+    {
+        return std::max(
+            std::min(remainingInMs - overheadInMs, moveTimeLimitInMs), 0);
+    }
+};
+}
@@ -1,10 +1,19 @@
 #pragma once
 
-#include <list>
-#include <unordered_map>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <new>
+#include <algorithm>
 #include <utility>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <cstring>
 #include <cstdint>
 
+#include <sys/mman.h>
+
 namespace Search {
 
 enum class Flag : int8_t
@@ -15,100 +24,375 @@ enum class Flag : int8_t
 };
 
 // A class implementing a transposition table for a game of type Game.
-// This table takes the form of a fixed size, LRU replacement hash table which
-// is used to store states, their values, the depths at which their values were
-// computed, and the types of values stored (EXACT, LOWER_BOUND, UPPER_BOUND).
+// This table takes the form of a fixed size array of buckets, each of which
+// fills a 64 byte cache line and holds a few entries. An entry stores the key
+// of a state, its value, the depth at which its value was computed, the type
+// of value stored (EXACT, LOWER_BOUND, UPPER_BOUND), the best action found if
+// any, and the generation of the search that stored it. States are identified
+// by their 64 bit hash alone, so probing a state costs a single cache miss.
+//
+// The table is never cleared between moves. Instead, a generation counter is
+// bumped at the start of every search, and when a bucket is full, the entry
+// with the lowest depth is replaced, where entries from older generations
+// count as shallower than they are. Entries from previous searches thus keep
+// producing cutoffs until newer and deeper ones need their place. The counter
+// wraps around after 4096 searches, which is more than a game takes, and the
+// table is cleared when it does, so that an old entry is never taken for one
+// of the current search.
+//
+// The table is sized in megabytes, which is a hard cap on its memory use. It
+// lives in a single mapping advised to use transparent huge pages, to cut down
+// on TLB misses, and its pages are touched by a background thread as soon as
+// it is created, so that the first search does not pay for the page faults.
+//
+// The table may be shared between threads without any locks. Each entry keeps
+// its packed data and the XOR of its key with that data. A reader only accepts
+// an entry when the two give back its key, so an entry torn by a concurrent
+// write is seen as a miss rather than as a wrong value.
 //
 // Game must define:
 //      StateType - The type of the state representation for a position.
-//          This type must be hashable using std::hash<StateType> and
-//          comparable for equality using the == operator.
-//      EvalType - The type of a numerical position evaluation.
+//          This type must be hashable using std::hash<StateType>, ideally with
+//          a cheap and well distributed hash such as a Zobrist key.
+//      ActionType - The type of an action in the game.
+//      EvalType - The type of a numerical position evaluation, which must be
+//          trivially copyable and fit in 32 bits.
+//
+//      static const int actionCodeCount
+//          The number of action codes, which must be less than 1023.
+//
+//      static int getActionCode(ActionType)
+//          A method to get the code in [0, actionCodeCount) of an action.
+//
+//      static ActionType getAction(int)
+//          A method to get the action with a given code.
 template <typename Game>
 class TranspositionTable
 {
 public:
     using StateType = typename Game::StateType;
+    using ActionType = typename Game::ActionType;
     using EvalType = typename Game::EvalType;
 
+    static_assert(
+        sizeof(EvalType) <= sizeof(uint32_t) &&
+            std::is_trivially_copyable<EvalType>::value,
+        "cannot pack the evaluation type");
+    static_assert(Game::actionCodeCount < 0x3FF, "cannot pack the actions");
+
     struct ValueType
     {
         EvalType value{};
         int depth{};
         Flag flag{};
+        // Whether the entry was stored by an earlier search.
+        bool isStale{};
+        // The best action, which is only known for exact values and cutoffs.
+        bool hasAction{};
+        ActionType action{};
 
         ValueType() = default;
-        ValueType(EvalType value, int depth, Flag flag)
-            : value{value}, depth{depth}, flag{flag}
+        ValueType(EvalType value, int depth, Flag flag, bool isStale = false)
+            : value{value}, depth{depth}, flag{flag}, isStale{isStale}
         {
         }
     };
 
-    TranspositionTable(size_t maxSize) : maxSize{maxSize}
+    TranspositionTable(size_t sizeInMb)
+    {
+        // The number of buckets is rounded down to a power of two, so that the
+        // bucket of a key can be found with a mask.
+        size_t bucketCount = 1;
+        while (2 * bucketCount * sizeof(Bucket) <= sizeInMb * 1024 * 1024)
+            bucketCount *= 2;
+        mask = bucketCount - 1;
+        size = bucketCount * sizeof(Bucket);
+
+        // Over-allocate so that the table can start on a huge page boundary,
+        // then give back what is left over on either side. Fresh anonymous
+        // memory is zeroed, which is an empty table.
+        auto mappingSize = size + hugePageSize;
+        auto mapping = mmap(
+            nullptr,
+            mappingSize,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS,
+            -1,
+            0);
+        if (mapping == MAP_FAILED)
+            throw std::bad_alloc{};
+        auto address = reinterpret_cast<uintptr_t>(mapping);
+        auto start = (address + hugePageSize - 1) & ~(hugePageSize - 1);
+        if (start > address)
+            munmap(mapping, start - address);
+        if (start + size < address + mappingSize)
+            munmap(
+                reinterpret_cast<void*>(start + size),
+                address + mappingSize - (start + size));
+        buckets = reinterpret_cast<Bucket*>(start);
+#ifdef MADV_HUGEPAGE
+        madvise(buckets, size, MADV_HUGEPAGE);
+#endif
+
+        prefaulter = std::thread{[this]() { prefault(); }};
+    }
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    ~TranspositionTable()
     {
+        waitUntilReady();
+        munmap(buckets, size);
     }
 
-    std::pair<bool, ValueType> find(const StateType& state)
+    // Waits for the background thread to be done touching the pages of the
+    // table, such as before timing a search, which it would otherwise slow
+    // down in proportion to the size of the table.
+    void waitUntilReady()
     {
-        ++accesses;
-        auto entry = table.find(state);
-        if (entry != std::end(table))
+        if (prefaulter.joinable())
+            prefaulter.join();
+    }
+
+    // Tells whether the background thread is done and joined, which only the
+    // thread that calls waitUntilReady() may ask.
+    bool isReady() const
+    {
+        return !prefaulter.joinable();
+    }
+
+    std::pair<bool, ValueType> find(const StateType& state) const
+    {
+        auto key = hasher(state);
+        for (const auto& entry : buckets[key & mask].entries)
         {
-            lru.splice(std::begin(lru), lru, entry->second);
-            return std::make_pair(true, entry->second->second);
+            auto data = entry.data.load(std::memory_order_relaxed);
+            auto check = entry.check.load(std::memory_order_relaxed);
+            if ((check ^ data) == key && !isEmpty(data))
+                return std::make_pair(true, unpack(data));
         }
-        ++misses;
         return std::make_pair(false, ValueType{});
     }
 
-    void emplace(const StateType& state, EvalType value, int depth, Flag flag)
+    // Gives the sequence of best actions from a state, as far as the table
+    // knows them, up to some length. This stops at a repetition, since the
+    // sequence would go round in circles.
+    std::vector<ActionType> getPrincipalVariation(
+        const Game& game, StateType state, size_t maxLength) const
     {
-        auto entry = table.find(state);
-        if (entry != std::end(table))
+        std::vector<ActionType> actions;
+        std::vector<uint64_t> keys{hasher(state)};
+        while (actions.size() < maxLength && !game.isTerminal(state))
         {
-            lru.splice(std::begin(lru), lru, entry->second);
-            entry->second->second = ValueType{value, depth, flag};
+            auto entry = find(state);
+            if (!entry.first || !entry.second.hasAction ||
+                !game.isLegal(state, entry.second.action))
+                break;
+            actions.push_back(entry.second.action);
+            game.makeMove(state, entry.second.action);
+            auto key = hasher(state);
+            if (std::find(std::begin(keys), std::end(keys), key) !=
+                std::end(keys))
+                break;
+            keys.push_back(key);
         }
-        else
+        return actions;
+    }
+
+    void emplace(const StateType& state, EvalType value, int depth, Flag flag)
+    {
+        store(state, value, depth, flag, 0);
+    }
+
+    void emplace(
+        const StateType& state,
+        EvalType value,
+        int depth,
+        Flag flag,
+        const ActionType& action)
+    {
+        store(state, value, depth, flag, Game::getActionCode(action) + 1);
+    }
+
+    // Starts a new generation of entries. This should be called at the start
+    // of every search, while no other thread uses the table.
+    void newSearch()
+    {
+        auto next =
+            (generation.load(std::memory_order_relaxed) + 1) & generationMask;
+        if (next == 0)
+            clear();
+        generation.store(next, std::memory_order_relaxed);
+    }
+
+    void clear()
+    {
+        for (size_t i = 0; i <= mask; ++i)
         {
-            lru.emplace_front(state, ValueType{value, depth, flag});
-            table[state] = std::begin(lru);
-            while (table.size() > maxSize)
+            for (auto& entry : buckets[i].entries)
             {
-                table.erase(lru.back().first);
-                lru.pop_back();
+                entry.data.store(0, std::memory_order_relaxed);
+                entry.check.store(0, std::memory_order_relaxed);
             }
         }
     }
 
-    void clear()
+    // Estimates the fraction of the entries in use from a sample of buckets.
+    double getUsage() const
     {
-        table.clear();
-        lru.clear();
+        size_t sampleSize = std::min(mask + 1, size_t{1024});
+        size_t used = 0;
+        for (size_t i = 0; i < sampleSize; ++i)
+            for (const auto& entry : buckets[i].entries)
+                if (!isEmpty(entry.data.load(std::memory_order_relaxed)))
+                    ++used;
+        return static_cast<double>(used) / (sampleSize * entriesPerBucket);
     }
 
-    size_t size() const
+private:
+    // The layout of the packed data of an entry. The flag is stored off by one,
+    // so that a zeroed entry is empty.
+    static const int valueShift = 0;
+    static const int depthShift = 32;
+    static const int flagShift = 40;
+    static const int generationShift = 42;
+    static const int actionShift = 54;
+    static const uint64_t depthMask = 0xFF;
+    static const uint64_t flagMask = 0x03;
+    static const uint64_t generationMask = 0xFFF;
+    static const uint64_t actionMask = 0x3FF;
+
+    static const size_t entriesPerBucket = 4;
+    static const size_t pageSize = 4096;
+    static const uintptr_t hugePageSize = 2 * 1024 * 1024;
+
+    struct Entry
     {
-        return table.size();
+        std::atomic<uint64_t> check{0};
+        std::atomic<uint64_t> data{0};
+    };
+
+    struct alignas(64) Bucket
+    {
+        Entry entries[entriesPerBucket];
+    };
+
+    static_assert(sizeof(Bucket) == 64, "buckets must fill a cache line");
+
+    std::hash<StateType> hasher;
+    Bucket* buckets{};
+    size_t mask{};
+    size_t size{};
+    // The generation is read by every thread of the search, as well as by
+    // those asking for the principal variation while it runs.
+    std::atomic<uint64_t> generation{0};
+
+    std::thread prefaulter;
+
+    // Writes to every page of the table to make the kernel back it with
+    // memory. The writes do not change any value, so the table can be used
+    // by the search while this runs.
+    void prefault()
+    {
+        auto bucketsPerPage = pageSize / sizeof(Bucket);
+        for (size_t i = 0; i <= mask; i += bucketsPerPage)
+            buckets[i].entries[0].check.fetch_or(0, std::memory_order_relaxed);
     }
 
-    double getHitRate() const
+    // Stores an entry, with an action code off by one, so that 0 means that
+    // there is no action.
+    void store(
+        const StateType& state,
+        EvalType value,
+        int depth,
+        Flag flag,
+        uint64_t actionCode)
     {
-        if (accesses == 0)
-            return 0.0;
-        return static_cast<double>(accesses - misses) / accesses;
+        auto key = hasher(state);
+        auto& bucket = buckets[key & mask];
+
+        // Overwrite the entry of the same state if there is one, and otherwise
+        // the entry least worth keeping.
+        Entry* replaced = nullptr;
+        auto replacedScore = std::numeric_limits<int>::max();
+        for (auto& entry : bucket.entries)
+        {
+            auto data = entry.data.load(std::memory_order_relaxed);
+            auto check = entry.check.load(std::memory_order_relaxed);
+            if (isEmpty(data))
+            {
+                replaced = &entry;
+                break;
+            }
+            if ((check ^ data) == key)
+            {
+                // Keep the best action of the state if we have none to give.
+                if (actionCode == 0)
+                    actionCode = (data >> actionShift) & actionMask;
+                replaced = &entry;
+                break;
+            }
+            auto score = getReplacementScore(data);
+            if (score < replacedScore)
+            {
+                replaced = &entry;
+                replacedScore = score;
+            }
+        }
+
+        auto data = pack(value, depth, flag) | (actionCode << actionShift);
+        replaced->data.store(data, std::memory_order_relaxed);
+        replaced->check.store(key ^ data, std::memory_order_relaxed);
     }
 
-private:
-    using ListType = std::list<std::pair<StateType, ValueType>>;
-    using MapType = std::unordered_map<StateType, typename ListType::iterator>;
+    uint64_t pack(EvalType value, int depth, Flag flag) const
+    {
+        uint32_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(value));
+        auto clampedDepth = std::min(std::max(depth, 0), int{depthMask});
+        return (uint64_t{bits} << valueShift) |
+            (static_cast<uint64_t>(clampedDepth) << depthShift) |
+            (static_cast<uint64_t>(static_cast<int>(flag) + 1) << flagShift) |
+            (generation.load(std::memory_order_relaxed) << generationShift);
+    }
 
-    MapType table;
-    ListType lru;
+    ValueType unpack(uint64_t data) const
+    {
+        auto bits = static_cast<uint32_t>(data >> valueShift);
+        EvalType value;
+        std::memcpy(&value, &bits, sizeof(value));
+        auto depth = static_cast<int>((data >> depthShift) & depthMask);
+        auto flagBits = static_cast<int>((data >> flagShift) & flagMask);
+        auto flag = static_cast<Flag>(flagBits - 1);
+        auto entryGeneration = (data >> generationShift) & generationMask;
+        auto isStale =
+            entryGeneration != generation.load(std::memory_order_relaxed);
+        ValueType result{value, depth, flag, isStale};
+        auto actionCode = static_cast<int>((data >> actionShift) & actionMask);
+        if (actionCode != 0)
+        {
+            result.hasAction = true;
+            result.action = Game::getAction(actionCode - 1);
+        }
+        return result;
+    }
 
-    size_t maxSize{};
+    bool isEmpty(uint64_t data) const
+    {
+        return ((data >> flagShift) & flagMask) == 0;
+    }
 
-    mutable int accesses{0};
-    mutable int misses{0};
+    // Entries from older generations are worth less than their depth says,
+    // since they are less likely to be probed again.
+    int getReplacementScore(uint64_t data) const
+    {
+        auto depth = static_cast<int>((data >> depthShift) & depthMask);
+        auto entryGeneration = (data >> generationShift) & generationMask;
+        auto age = (generation.load(std::memory_order_relaxed) -
+                    entryGeneration) &
+            generationMask;
+        return depth - 8 * static_cast<int>(age);
+    }
 };
 }
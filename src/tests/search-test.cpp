@@ -0,0 +1,90 @@
+#include <sstream>
+
+#include "game/bitboard-game.h"
+#include "game/heuristics.h"
+#include "search/iterative-alpha-beta.h"
+#include "search/mtdf.h"
+#include "tests/test.h"
+
+using namespace DynamicConnect4;
+using namespace Search;
+
+namespace {
+
+// A state in which player one has no legal action, with its pieces walled in
+// the corners, and in which no one has won.
+BitboardState getBlockedState()
+{
+    std::stringstream in{"O,O,X, , , , \n"
+                         "O,X, , , , , \n"
+                         "X, , , , , , \n"
+                         " , , , , , , \n"
+                         " , , , , , ,X\n"
+                         " , , , , ,X,O\n"
+                         " , , , ,X,O,O\n"};
+    State state;
+    in >> state;
+    return BitboardState{state};
+}
+
+template <typename Searcher>
+void testWithoutActions(const std::string& name)
+{
+    BitboardGame game;
+    auto state = getBlockedState();
+    Options options;
+    options.hashSizeInMb = 1;
+    options.threads = 4;
+    Searcher searcher{game, false, options};
+    Limits limits;
+    limits.depth = 4;
+    searcher.search(state, ConnectedPiecesV4{}, limits, true);
+    Test::check(
+        searcher.getLastDepth() == 0 && searcher.getLastCount() == 1,
+        name + " returns at once from a state without actions");
+}
+
+// A search stopped by its id before it starts returns at once, but neither a
+// stop of an earlier search nor one without a search in progress affects the
+// next one.
+template <typename Searcher>
+void testStopBeforeStart(const std::string& name)
+{
+    BitboardGame game;
+    BitboardState state;
+    Options options;
+    options.hashSizeInMb = 1;
+    Searcher searcher{game, false, options};
+    Limits limits;
+    limits.depth = 3;
+
+    searcher.stop(searcher.getNextSearchId());
+    searcher.search(state, ConnectedPiecesV4{}, limits, true);
+    Test::check(
+        searcher.getLastDepth() == 0,
+        name + " starts stopped when stopped by its id before it starts");
+
+    auto searchId = searcher.getNextSearchId();
+    searcher.search(state, ConnectedPiecesV4{}, limits, true);
+    searcher.stop(searchId);
+    searcher.stop();
+    searcher.search(state, ConnectedPiecesV4{}, limits, true);
+    Test::check(
+        searcher.getLastDepth() == 3,
+        name + " ignores the stops of earlier searches");
+}
+}
+
+int main()
+{
+    BitboardGame game;
+    auto state = getBlockedState();
+    Test::check(
+        game.getActions(state).empty() && !game.isTerminal(state),
+        "the blocked state has no actions and is not terminal");
+    testWithoutActions<IterativeAlphaBeta<BitboardGame>>("IterativeAlphaBeta");
+    testWithoutActions<MTDf<BitboardGame>>("MTDf");
+    testStopBeforeStart<IterativeAlphaBeta<BitboardGame>>("IterativeAlphaBeta");
+    testStopBeforeStart<MTDf<BitboardGame>>("MTDf");
+    return Test::getStatus("search");
+}
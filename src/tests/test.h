@@ -0,0 +1,35 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+namespace Test {
+
+// The number of checks that failed so far.
+inline int& getFailureCount()
+{
+    static int failureCount = 0;
+    return failureCount;
+}
+
+// Checks a condition, and describes the check if it fails.
+inline void check(bool condition, const std::string& description)
+{
+    if (condition)
+        return;
+    std::cerr << "check failed: " << description << std::endl;
+    ++getFailureCount();
+}
+
+// Gives the exit status of a test, which fails if any of its checks did.
+inline int getStatus(const std::string& name)
+{
+    auto failureCount = getFailureCount();
+    if (failureCount > 0)
+        std::cerr << name << ": " << failureCount << " checks failed"
+                  << std::endl;
+    else
+        std::cout << name << ": all checks passed" << std::endl;
+    return failureCount > 0 ? 1 : 0;
+}
+}
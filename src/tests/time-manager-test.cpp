@@ -0,0 +1,96 @@
+#include "game/bitboard-game.h"
+#include "game/heuristics.h"
+#include "search/iterative-alpha-beta.h"
+#include "search/time-manager.h"
+#include "tests/test.h"
+
+using namespace DynamicConnect4;
+using namespace Search;
+
+namespace {
+
+void testWithoutBudget()
+{
+    GameClock clock{5000};
+    clock.update(4000);
+    Test::check(
+        clock.getTargetTimeInMs() == 5000 && clock.getTimeLimitInMs() == 5000,
+        "every move gets the time limit per move without a budget");
+}
+
+void testShareOfBudget()
+{
+    GameClock clock{5000, 40000};
+    Test::check(
+        clock.getTargetTimeInMs() == 1000,
+        "a move aims for an even share of the budget");
+    Test::check(
+        clock.getTimeLimitInMs() == 3000,
+        "a move may take three times its share of the budget");
+
+    GameClock shortClock{2000, 400000};
+    Test::check(
+        shortClock.getTargetTimeInMs() == 2000 &&
+            shortClock.getTimeLimitInMs() == 2000,
+        "a move takes no longer than the time limit per move");
+}
+
+void testLowBudget()
+{
+    // The share of the budget is below the least time of a move, which it
+    // gets while there is that much left beyond the overhead.
+    GameClock clock{5000, 200};
+    Test::check(
+        clock.getTargetTimeInMs() == 10,
+        "a move gets some time while the budget lasts");
+
+    // The search must then complete its first iteration, rather than play
+    // the first legal action unsearched.
+    BitboardGame game;
+    Options options;
+    options.hashSizeInMb = 1;
+    IterativeAlphaBeta<BitboardGame> searcher{game, false, options};
+    searcher.waitUntilReady();
+    searcher.search(
+        BitboardState{}, ConnectedPiecesV4{}, clock.getLimits(), true);
+    Test::check(
+        searcher.getLastDepth() >= 1,
+        "the search completes an iteration within the least time of a move");
+
+    GameClock shortClock{5, 1000};
+    shortClock.update(900);
+    Test::check(
+        shortClock.getTimeLimitInMs() <= 5,
+        "the least time of a move is within the time limit per move");
+}
+
+void testExhaustedBudget()
+{
+    GameClock clock{5000, 1000};
+    clock.update(960);
+    Test::check(
+        clock.getTargetTimeInMs() == 0 && clock.getTimeLimitInMs() == 0,
+        "a move gets no time once what is left is within the overhead");
+
+    clock.update(100);
+    Test::check(
+        clock.getTargetTimeInMs() == 0 && clock.getTimeLimitInMs() == 0,
+        "a move gets no time once the budget is overrun");
+
+    GameClock lastClock{5000, 1000};
+    lastClock.update(940);
+    Test::check(
+        lastClock.getTargetTimeInMs() == 10 &&
+            lastClock.getTimeLimitInMs() == 10,
+        "a move takes no longer than what is left minus the overhead");
+}
+}
+
+int main()
+{
+    testWithoutBudget();
+    testShareOfBudget();
+    testLowBudget();
+    testExhaustedBudget();
+    return Test::getStatus("time-manager");
+}
@@ -0,0 +1,55 @@
+#include "game/bitboard-game.h"
+#include "search/transposition-table.h"
+#include "tests/test.h"
+
+using namespace DynamicConnect4;
+using namespace Search;
+
+namespace {
+
+// An entry is stale from the next search on, and it is gone once the
+// generations wrap around, rather than taken for one of the current search.
+void testGenerations()
+{
+    TranspositionTable<BitboardGame> table{1};
+    BitboardState state;
+    table.emplace(state, 1.0f, 5, Flag::exact);
+    auto entry = table.find(state);
+    Test::check(
+        entry.first && !entry.second.isStale && entry.second.depth == 5,
+        "an entry of the current search is found and not stale");
+
+    table.newSearch();
+    entry = table.find(state);
+    Test::check(
+        entry.first && entry.second.isStale,
+        "an entry of the previous search is stale");
+
+    for (int i = 1; i < 4096; ++i)
+        table.newSearch();
+    entry = table.find(state);
+    Test::check(
+        !entry.first,
+        "an entry is not taken for a current one after the generations wrap");
+}
+
+// The background thread that prepares the table is only joined by
+// waitUntilReady(), once it is done, and waiting again returns at once.
+void testWaitUntilReady()
+{
+    TranspositionTable<BitboardGame> table{64};
+    Test::check(!table.isReady(), "the table is not ready before waiting");
+    table.waitUntilReady();
+    Test::check(
+        table.isReady(), "the table is ready once waitUntilReady() returns");
+    table.waitUntilReady();
+    Test::check(table.isReady(), "the table stays ready after waiting again");
+}
+}
+
+int main()
+{
+    testGenerations();
+    testWaitUntilReady();
+    return Test::getStatus("transposition-table");
+}
@@ -0,0 +1,449 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+
+#include "args.h"
+#include "game/game.h"
+#include "game/bitboard-game.h"
+#include "game/heuristics.h"
+#include "search/minimax.h"
+#include "search/alpha-beta.h"
+#include "search/ordered-alpha-beta.h"
+#include "search/iterative-alpha-beta.h"
+#include "search/mtdf.h"
+#include "search/limits.h"
+#include "search/options.h"
+
+using namespace DynamicConnect4;
+using namespace Search;
+
+using StateType = BitboardGame::StateType;
+using ActionType = BitboardGame::ActionType;
+using EvalType = BitboardGame::EvalType;
+
+// This searches some states to each depth of a range with each engine, to
+// measure the effect of a change on the nodes searched and on the speed of the
+// search. Every search starts with a new engine, so the results only depend on
+// the code. The results are printed as CSV or JSON, with a line per search:
+//      state, engine, depth, action, nodes, seconds, nps, branching
+// where the branching factor is the ratio of the nodes to those of the depth
+// before. The results can be compared with those of a previous run given as a
+// baseline in CSV, in which case the differences are printed to stderr.
+
+namespace {
+
+struct Settings
+{
+    int minDepth{3};
+    int maxDepth{6};
+    std::vector<std::string> engines{"minimax",
+                                     "alpha-beta",
+                                     "ordered-alpha-beta",
+                                     "iterative-alpha-beta",
+                                     "mtdf"};
+    Options options;
+    bool json{false};
+    std::string baselineFile;
+    std::vector<std::string> files;
+    bool help{false};
+};
+
+struct Result
+{
+    std::string state;
+    std::string engine;
+    int depth{0};
+    std::string action;
+    long long nodes{0};
+    double seconds{0};
+    double branching{0};
+};
+
+const Heuristic<ConnectedPiecesV1, CentralDominanceV2> heuristic{1.0f, 1.0f};
+
+void setResult(
+    Result& result,
+    const ActionType& action,
+    long long nodes,
+    std::chrono::steady_clock::duration time)
+{
+    std::stringstream ss;
+    ss << action;
+    result.action = ss.str();
+    result.nodes = nodes;
+    result.seconds = std::chrono::duration<double>(time).count();
+}
+
+// Searches a state to a depth, and fills in the action, nodes and time of the
+// result. The time does not include the creation of the engine, nor the
+// preparation of its transposition table, which depends on its size.
+using Benchmark = std::function<void(const StateType&, int, Result&)>;
+
+template <typename Searcher>
+void searchToDepth(const StateType& state, int depth, Result& result)
+{
+    BitboardGame game;
+    Searcher searcher{game};
+    auto t1 = std::chrono::steady_clock::now();
+    auto action = searcher.search(state, heuristic, depth, state.isPlayerOne);
+    auto t2 = std::chrono::steady_clock::now();
+    setResult(result, action, searcher.getLastCount(), t2 - t1);
+}
+
+template <typename Searcher>
+void searchIteratively(
+    const StateType& state, int depth, const Options& options, Result& result)
+{
+    BitboardGame game;
+    Searcher searcher{game, false, options};
+    Limits limits;
+    limits.depth = depth;
+    searcher.waitUntilReady();
+    auto t1 = std::chrono::steady_clock::now();
+    auto action = searcher.search(state, heuristic, limits, state.isPlayerOne);
+    auto t2 = std::chrono::steady_clock::now();
+    setResult(result, action, searcher.getLastCount(), t2 - t1);
+}
+
+Benchmark getBenchmark(const std::string& engine, const Options& options)
+{
+    if (engine == "minimax")
+        return searchToDepth<Minimax<BitboardGame>>;
+    if (engine == "alpha-beta")
+        return searchToDepth<AlphaBeta<BitboardGame>>;
+    if (engine == "ordered-alpha-beta")
+        return searchToDepth<OrderedAlphaBeta<BitboardGame>>;
+    if (engine == "iterative-alpha-beta")
+        return [options](const StateType& state, int depth, Result& result) {
+            searchIteratively<IterativeAlphaBeta<BitboardGame>>(
+                state, depth, options, result);
+        };
+    if (engine == "mtdf")
+        return [options](const StateType& state, int depth, Result& result) {
+            searchIteratively<MTDf<BitboardGame>>(
+                state, depth, options, result);
+        };
+    throw Args::ArgsError{"invalid engine: " + engine};
+}
+
+std::vector<Result> runBenchmarks(const Settings& settings)
+{
+    std::vector<std::pair<std::string, StateType>> states;
+    states.emplace_back("initial", StateType{});
+    for (const auto& file : settings.files)
+        states.emplace_back(file, Args::getState<BitboardGame>(file));
+
+    std::vector<Result> results;
+    for (const auto& state : states)
+    {
+        for (const auto& engine : settings.engines)
+        {
+            auto benchmark = getBenchmark(engine, settings.options);
+            long long lastNodes = 0;
+            for (int depth = settings.minDepth; depth <= settings.maxDepth;
+                 ++depth)
+            {
+                std::cerr << state.first << " " << engine << " " << depth
+                          << std::endl;
+                Result result;
+                result.state = state.first;
+                result.engine = engine;
+                result.depth = depth;
+                benchmark(state.second, depth, result);
+                if (lastNodes > 0)
+                    result.branching =
+                        static_cast<double>(result.nodes) / lastNodes;
+                lastNodes = result.nodes;
+                results.push_back(result);
+            }
+        }
+    }
+    return results;
+}
+
+double getNodesPerSecond(const Result& result)
+{
+    return result.nodes / std::max(result.seconds, 1e-9);
+}
+
+void printCsv(std::ostream& out, const std::vector<Result>& results)
+{
+    out << "state,engine,depth,action,nodes,seconds,nps,branching"
+        << std::endl;
+    for (const auto& result : results)
+        out << result.state << "," << result.engine << "," << result.depth
+            << "," << result.action << "," << result.nodes << ","
+            << std::fixed << std::setprecision(6) << result.seconds << ","
+            << std::setprecision(0) << getNodesPerSecond(result) << ","
+            << std::setprecision(3) << result.branching << std::defaultfloat
+            << std::endl;
+}
+
+void printJson(std::ostream& out, const std::vector<Result>& results)
+{
+    out << "[" << std::endl;
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const auto& result = results[i];
+        out << "  {\"state\": \"" << result.state << "\", \"engine\": \""
+            << result.engine << "\", \"depth\": " << result.depth
+            << ", \"action\": \"" << result.action
+            << "\", \"nodes\": " << result.nodes << ", \"seconds\": "
+            << std::fixed << std::setprecision(6) << result.seconds
+            << ", \"nps\": " << std::setprecision(0)
+            << getNodesPerSecond(result) << ", \"branching\": "
+            << std::setprecision(3) << result.branching << std::defaultfloat
+            << "}" << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    out << "]" << std::endl;
+}
+
+std::vector<Result> readCsv(const std::string& file)
+{
+    std::ifstream in{file};
+    if (!in)
+        throw std::runtime_error{"file not found: " + file};
+    std::vector<Result> results;
+    std::string line;
+    std::getline(in, line);
+    while (std::getline(in, line))
+    {
+        std::stringstream ss{line};
+        Result result;
+        std::string field;
+        std::getline(ss, result.state, ',');
+        std::getline(ss, result.engine, ',');
+        std::getline(ss, field, ',');
+        result.depth = std::stoi(field);
+        std::getline(ss, result.action, ',');
+        std::getline(ss, field, ',');
+        result.nodes = std::stoll(field);
+        std::getline(ss, field, ',');
+        result.seconds = std::stod(field);
+        if (!ss)
+            throw std::runtime_error{"invalid baseline in " + file};
+        results.push_back(result);
+    }
+    return results;
+}
+
+// Prints the relative differences of the nodes and of the speed with the
+// baseline for each search, and their geometric means over all searches.
+void compare(
+    const std::vector<Result>& results, const std::vector<Result>& baseline)
+{
+    std::map<std::string, Result> baselineResults;
+    for (const auto& result : baseline)
+        baselineResults[result.state + " " + result.engine + " " +
+                        std::to_string(result.depth)] = result;
+
+    double nodesLogSum = 0;
+    double speedLogSum = 0;
+    int count = 0;
+    std::cerr << std::fixed << std::setprecision(1);
+    for (const auto& result : results)
+    {
+        auto key = result.state + " " + result.engine + " " +
+            std::to_string(result.depth);
+        auto it = baselineResults.find(key);
+        if (it == std::end(baselineResults) || it->second.nodes == 0 ||
+            result.nodes == 0)
+            continue;
+        const auto& old = it->second;
+        auto nodesRatio = static_cast<double>(result.nodes) / old.nodes;
+        auto speedRatio =
+            getNodesPerSecond(result) / getNodesPerSecond(old);
+        nodesLogSum += std::log(nodesRatio);
+        speedLogSum += std::log(speedRatio);
+        ++count;
+        std::cerr << key << ": nodes " << std::showpos
+                  << 100 * (nodesRatio - 1) << "%, nps "
+                  << 100 * (speedRatio - 1) << "%" << std::noshowpos;
+        if (result.action != old.action)
+            std::cerr << ", action " << old.action << " -> " << result.action;
+        std::cerr << std::endl;
+    }
+    if (count > 0)
+        std::cerr << "mean over " << count << " searches: nodes "
+                  << std::showpos
+                  << 100 * (std::exp(nodesLogSum / count) - 1) << "%, nps "
+                  << 100 * (std::exp(speedLogSum / count) - 1) << "%"
+                  << std::noshowpos << std::endl;
+    else
+        std::cerr << "no searches in common with the baseline" << std::endl;
+    std::cerr << std::defaultfloat;
+}
+
+Settings parse(int argc, char** argv)
+{
+    Settings settings;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg{argv[i]};
+        if (arg.empty())
+            throw Args::ArgsError{"invalid argument: " + arg};
+        if (arg[0] != '-')
+        {
+            settings.files.push_back(arg);
+            continue;
+        }
+        if (arg.length() < 2)
+            throw Args::ArgsError{"invalid argument: " + arg};
+        switch (arg[1])
+        {
+        case 'd':
+        {
+            std::stringstream ss{arg.substr(2)};
+            char colon;
+            ss >> settings.minDepth >> colon >> settings.maxDepth;
+            if (!ss || colon != ':' || !ss.eof() || settings.minDepth < 1 ||
+                settings.minDepth > settings.maxDepth)
+                throw Args::ArgsError{"invalid argument: " + arg};
+            break;
+        }
+        case 'e':
+        {
+            settings.engines.clear();
+            std::stringstream ss{arg.substr(2)};
+            std::string engine;
+            while (std::getline(ss, engine, ','))
+            {
+                getBenchmark(engine, settings.options);
+                settings.engines.push_back(engine);
+            }
+            if (settings.engines.empty())
+                throw Args::ArgsError{"invalid argument: " + arg};
+            break;
+        }
+        case 'j':
+        {
+            settings.options.threads = Args::parseNumber<int>(arg);
+            if (settings.options.threads < 1)
+                throw Args::ArgsError{"invalid argument: " + arg};
+            break;
+        }
+        case 'm':
+        {
+            settings.options.hashSizeInMb = Args::parseNumber<int>(arg);
+            if (settings.options.hashSizeInMb < 1)
+                throw Args::ArgsError{"invalid argument: " + arg};
+            break;
+        }
+        case 'J':
+        {
+            settings.json = true;
+            break;
+        }
+        case 'b':
+        {
+            settings.baselineFile = arg.substr(2);
+            break;
+        }
+        case 'H':
+        {
+            settings.help = true;
+            break;
+        }
+        default:
+        {
+            throw Args::ArgsError{"invalid argument: " + arg};
+        }
+        }
+    }
+    return settings;
+}
+
+void printUsage(const std::string& progname)
+{
+    Settings settings;
+    std::cerr
+        << std::boolalpha << "Usage: " << progname
+        << " [-d<min>:<max>] [-e<engine>,...] [-j<threads>] [-m<MB>] [-J]"
+        << std::endl
+        << "       " << std::string(progname.length(), ' ')
+        << " [-b<filename>] [-H]" << std::endl
+        << "       " << std::string(progname.length(), ' ')
+        << " [<filename>...]" << std::endl
+        << std::endl
+        << "    -d<min>:<max>:  "
+           "Search to each depth from min to max. Defaults to "
+        << settings.minDepth << ":" << settings.maxDepth << "." << std::endl
+        << "    -e<engine>,...: "
+           "Search with the specified engines among minimax, alpha-beta,"
+        << std::endl
+        << "                    "
+           "ordered-alpha-beta, iterative-alpha-beta and mtdf. Defaults to "
+           "all."
+        << std::endl
+        << "    -j<threads>:    "
+           "Search with the specified number of threads, which only"
+        << std::endl
+        << "                    "
+           "iterative-alpha-beta uses. Defaults to "
+        << settings.options.threads << "." << std::endl
+        << "    -m<MB>:         "
+           "Limit the transposition table to the specified size in MB. "
+           "Defaults to "
+        << settings.options.hashSizeInMb << " MB." << std::endl
+        << "    -J:             "
+           "Print the results as JSON instead of CSV. Defaults to "
+        << settings.json << "." << std::endl
+        << "    -b<filename>:   "
+           "Compare the results with those in the given CSV file."
+        << std::endl
+        << "    -H:             "
+           "Print usage information."
+        << std::endl
+        << "    <filename>:     "
+           "Search the state in the given file as well as the initial state."
+        << std::endl;
+}
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        auto settings = parse(argc, argv);
+        if (settings.help)
+        {
+            printUsage(argv[0]);
+            return 0;
+        }
+
+        std::vector<Result> baseline;
+        if (!settings.baselineFile.empty())
+            baseline = readCsv(settings.baselineFile);
+        auto results = runBenchmarks(settings);
+        if (settings.json)
+            printJson(std::cout, results);
+        else
+            printCsv(std::cout, results);
+        if (!settings.baselineFile.empty())
+            compare(results, baseline);
+        return 0;
+    }
+    catch (Args::ArgsError& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 2;
+    }
+    catch (...)
+    {
+        return 3;
+    }
+}
@@ -0,0 +1,300 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <utility>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+
+#include "args.h"
+#include "game/game.h"
+#include "game/bitboard-game.h"
+#include "game/heuristics.h"
+
+using namespace DynamicConnect4;
+
+// This times the primitives of the game and the heuristics in nanoseconds per
+// call, for both Game and BitboardGame, on the positions of the games in some
+// logs, such as those in the game-tournament directory. Each primitive is
+// called on every position in turn, or on every action of every position,
+// until some time has passed, so the times include the cost of the loop and
+// of the cache misses of a realistic mix of positions.
+
+namespace {
+
+struct Settings
+{
+    int timeInMs{200};
+    std::vector<std::string> files;
+    bool help{false};
+};
+
+// Keeps the compiler from optimizing away the computation of a value.
+template <typename T>
+void doNotOptimize(const T& value)
+{
+    asm volatile("" : : "m"(value) : "memory");
+}
+
+// Reads the positions of the games in a log. A position is a board following
+// a line with the numbers of the columns. The players take turns from the
+// first position, which player one is to play.
+std::vector<State> readPositions(const std::string& file)
+{
+    std::ifstream in{file};
+    if (!in)
+        throw std::runtime_error{"file not found: " + file};
+    std::vector<State> positions;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (line != "  1 2 3 4 5 6 7")
+            continue;
+
+        // Each row starts with its number and a space.
+        std::string rows;
+        for (int i = 0; i < boardSize && std::getline(in, line); ++i)
+            rows += line.substr(std::min<size_t>(2, line.length())) + "\n";
+        std::stringstream board{rows};
+        State state;
+        if (!(board >> state))
+            throw std::runtime_error{"invalid position in " + file};
+        state.isPlayerOne = positions.size() % 2 == 0;
+        positions.push_back(state);
+    }
+    return positions;
+}
+
+// Calls a function on each item in turn until some time has passed, and gives
+// the time per call in nanoseconds. The function gives the number of calls it
+// made.
+template <typename Item, typename Function>
+double timeCalls(std::vector<Item>& items, Function function, int timeInMs)
+{
+    long long calls = 0;
+    auto t1 = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration time;
+    do
+    {
+        for (auto& item : items)
+            calls += function(item);
+        time = std::chrono::steady_clock::now() - t1;
+    } while (time < std::chrono::milliseconds{timeInMs});
+    return std::chrono::duration<double, std::nano>(time).count() / calls;
+}
+
+template <typename Game, typename Heuristic>
+std::pair<std::string, double> timeHeuristic(
+    const std::string& name,
+    std::vector<typename Game::StateType>& states,
+    int timeInMs)
+{
+    Heuristic heuristic;
+    return {name,
+            timeCalls(
+                states,
+                [&](const typename Game::StateType& state) {
+                    doNotOptimize(heuristic(state));
+                    return 1;
+                },
+                timeInMs)};
+}
+
+template <typename Game>
+std::vector<std::pair<std::string, double>> timePrimitives(
+    const std::vector<State>& positions, int timeInMs)
+{
+    using StateType = typename Game::StateType;
+    using ActionType = typename Game::ActionType;
+
+    Game game;
+    std::vector<StateType> states;
+    std::vector<std::pair<StateType, ActionType>> moves;
+    for (const auto& position : positions)
+    {
+        states.emplace_back(position);
+        for (const auto& action : game.getActions(states.back()))
+            moves.emplace_back(states.back(), action);
+    }
+
+    std::vector<std::pair<std::string, double>> results;
+    results.emplace_back(
+        "isTerminal",
+        timeCalls(
+            states,
+            [&](const StateType& state) {
+                doNotOptimize(game.isTerminal(state));
+                return 1;
+            },
+            timeInMs));
+    results.emplace_back(
+        "getActions",
+        timeCalls(
+            states,
+            [&](const StateType& state) {
+                doNotOptimize(game.getActions(state));
+                return 1;
+            },
+            timeInMs));
+    results.emplace_back(
+        "getResult",
+        timeCalls(
+            moves,
+            [&](const std::pair<StateType, ActionType>& move) {
+                doNotOptimize(game.getResult(move.first, move.second));
+                return 1;
+            },
+            timeInMs));
+    results.emplace_back(
+        "makeMove + unmakeMove",
+        timeCalls(
+            moves,
+            [&](std::pair<StateType, ActionType>& move) {
+                game.makeMove(move.first, move.second);
+                doNotOptimize(move.first);
+                game.unmakeMove(move.first, move.second);
+                return 1;
+            },
+            timeInMs));
+    results.emplace_back(
+        "std::hash",
+        timeCalls(
+            states,
+            [&](const StateType& state) {
+                doNotOptimize(std::hash<StateType>{}(state));
+                return 1;
+            },
+            timeInMs));
+    results.push_back(timeHeuristic<Game, ConnectedPiecesV1>(
+        "ConnectedPiecesV1", states, timeInMs));
+    results.push_back(timeHeuristic<Game, ConnectedPiecesV2>(
+        "ConnectedPiecesV2", states, timeInMs));
+    results.push_back(timeHeuristic<Game, ConnectedPiecesV3>(
+        "ConnectedPiecesV3", states, timeInMs));
+    results.push_back(timeHeuristic<Game, ConnectedPiecesV4>(
+        "ConnectedPiecesV4", states, timeInMs));
+    results.push_back(timeHeuristic<Game, CentralDominanceV1>(
+        "CentralDominanceV1", states, timeInMs));
+    results.push_back(timeHeuristic<Game, CentralDominanceV2>(
+        "CentralDominanceV2", states, timeInMs));
+    return results;
+}
+
+Settings parse(int argc, char** argv)
+{
+    Settings settings;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg{argv[i]};
+        if (arg.empty())
+            throw Args::ArgsError{"invalid argument: " + arg};
+        if (arg[0] != '-')
+        {
+            settings.files.push_back(arg);
+            continue;
+        }
+        if (arg.length() < 2)
+            throw Args::ArgsError{"invalid argument: " + arg};
+        switch (arg[1])
+        {
+        case 't':
+        {
+            settings.timeInMs = Args::parseNumber<int>(arg);
+            if (settings.timeInMs < 1)
+                throw Args::ArgsError{"invalid argument: " + arg};
+            break;
+        }
+        case 'H':
+        {
+            settings.help = true;
+            break;
+        }
+        default:
+        {
+            throw Args::ArgsError{"invalid argument: " + arg};
+        }
+        }
+    }
+    if (settings.files.empty() && !settings.help)
+        throw Args::ArgsError{"no log files given"};
+    return settings;
+}
+
+void printUsage(const std::string& progname)
+{
+    Settings settings;
+    std::cerr << "Usage: " << progname << " [-t<ms>] [-H] <filename>..."
+              << std::endl
+              << std::endl
+              << "    -t<ms>:       "
+                 "Time each primitive for at least the specified time in ms. "
+                 "Defaults to "
+              << settings.timeInMs << " ms." << std::endl
+              << "    -H:           "
+                 "Print usage information."
+              << std::endl
+              << "    <filename>:   "
+                 "Time the primitives on the positions of the games in the "
+                 "given log."
+              << std::endl;
+}
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        auto settings = parse(argc, argv);
+        if (settings.help)
+        {
+            printUsage(argv[0]);
+            return 0;
+        }
+
+        std::vector<State> positions;
+        for (const auto& file : settings.files)
+        {
+            auto filePositions = readPositions(file);
+            positions.insert(
+                std::end(positions),
+                std::begin(filePositions),
+                std::end(filePositions));
+        }
+        if (positions.empty())
+            throw std::runtime_error{"no positions in the logs"};
+
+        auto gameResults = timePrimitives<Game>(positions, settings.timeInMs);
+        auto bitboardResults =
+            timePrimitives<BitboardGame>(positions, settings.timeInMs);
+        std::cout << positions.size() << " positions, in ns per call"
+                  << std::endl
+                  << std::left << std::setw(24) << "primitive" << std::right
+                  << std::setw(12) << "Game" << std::setw(16)
+                  << "BitboardGame" << std::endl
+                  << std::fixed << std::setprecision(1);
+        for (size_t i = 0; i < gameResults.size(); ++i)
+            std::cout << std::left << std::setw(24) << gameResults[i].first
+                      << std::right << std::setw(12) << gameResults[i].second
+                      << std::setw(16) << bitboardResults[i].second
+                      << std::endl;
+        return 0;
+    }
+    catch (Args::ArgsError& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 2;
+    }
+    catch (...)
+    {
+        return 3;
+    }
+}
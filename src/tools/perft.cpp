@@ -0,0 +1,262 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+
+#include "args.h"
+#include "game/game.h"
+#include "game/bitboard-game.h"
+
+using namespace DynamicConnect4;
+
+// This counts the sequences of actions of each length up to a depth from some
+// states (perft), to measure the speed of the move generation and to check
+// it. A sequence ends early at a state where a player has won, so such a state
+// only counts at the last ply. The results of the actions at the last ply are
+// counted without being made (bulk counting).
+//
+// The counts of BitboardGame can be checked against those of Game for each
+// action of the state (divide), which catches the mistakes of either.
+
+namespace {
+
+struct Settings
+{
+    int depth{6};
+    int threads{1};
+    bool divide{false};
+    bool check{false};
+    std::vector<std::string> files;
+    bool help{false};
+};
+
+template <typename Game>
+long long perft(
+    const Game& game, const typename Game::StateType& state, int depth)
+{
+    if (depth == 0)
+        return 1;
+    if (game.isTerminal(state))
+        return 0;
+    auto actions = game.getActions(state);
+    if (depth == 1)
+        return actions.size();
+    long long count = 0;
+    for (const auto& action : actions)
+        count += perft(game, game.getResult(state, action), depth - 1);
+    return count;
+}
+
+// The counts below each action of a state, indexed by action code. The
+// actions are split among the threads.
+template <typename Game>
+std::vector<long long> divide(
+    const Game& game,
+    const typename Game::StateType& state,
+    int depth,
+    int threads)
+{
+    std::vector<long long> counts(Game::actionCodeCount, -1);
+    if (game.isTerminal(state))
+        return counts;
+    auto actions = game.getActions(state);
+    std::atomic<int> next{0};
+    auto work = [&]() {
+        for (int i = next++; i < static_cast<int>(actions.size()); i = next++)
+            counts[Game::getActionCode(actions[i])] =
+                perft(game, game.getResult(state, actions[i]), depth - 1);
+    };
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; ++i)
+        workers.emplace_back(work);
+    work();
+    for (auto& worker : workers)
+        worker.join();
+    return counts;
+}
+
+long long sum(const std::vector<long long>& counts)
+{
+    long long result = 0;
+    for (auto count : counts)
+        result += std::max(count, 0LL);
+    return result;
+}
+
+// Runs perft on a state for each depth, and returns whether the counts of
+// both games agree if they are checked.
+bool run(const Settings& settings, const State& state)
+{
+    BitboardGame bitboardGame;
+    Game game;
+    BitboardState bitboardState{state};
+    bool isCorrect = true;
+    for (int depth = 1; depth <= settings.depth; ++depth)
+    {
+        auto t1 = std::chrono::steady_clock::now();
+        auto counts =
+            divide(bitboardGame, bitboardState, depth, settings.threads);
+        auto t2 = std::chrono::steady_clock::now();
+        auto seconds = std::chrono::duration<double>(t2 - t1).count();
+        auto count = sum(counts);
+        std::cout << "depth " << depth << ": " << count << " nodes in "
+                  << std::fixed << std::setprecision(3) << seconds << " s ("
+                  << std::setprecision(0) << count / std::max(seconds, 1e-9)
+                  << " nodes/s)" << std::defaultfloat << std::endl;
+
+        if (settings.check)
+        {
+            auto expected = divide(game, state, depth, settings.threads);
+            for (int code = 0; code < Game::actionCodeCount; ++code)
+            {
+                if (counts[code] == expected[code])
+                    continue;
+                isCorrect = false;
+                std::cout << "    mismatch for " << Game::getAction(code)
+                          << ": " << counts[code] << " instead of "
+                          << expected[code] << std::endl;
+            }
+        }
+
+        if (settings.divide && depth == settings.depth)
+            for (int code = 0; code < Game::actionCodeCount; ++code)
+                if (counts[code] >= 0)
+                    std::cout << "    " << Game::getAction(code) << ": "
+                              << counts[code] << std::endl;
+    }
+    return isCorrect;
+}
+
+Settings parse(int argc, char** argv)
+{
+    Settings settings;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg{argv[i]};
+        if (arg.empty())
+            throw Args::ArgsError{"invalid argument: " + arg};
+        if (arg[0] != '-')
+        {
+            settings.files.push_back(arg);
+            continue;
+        }
+        if (arg.length() < 2)
+            throw Args::ArgsError{"invalid argument: " + arg};
+        switch (arg[1])
+        {
+        case 'd':
+        {
+            settings.depth = Args::parseNumber<int>(arg);
+            if (settings.depth < 1)
+                throw Args::ArgsError{"invalid argument: " + arg};
+            break;
+        }
+        case 'j':
+        {
+            settings.threads = Args::parseNumber<int>(arg);
+            if (settings.threads < 1)
+                throw Args::ArgsError{"invalid argument: " + arg};
+            break;
+        }
+        case 'v':
+        {
+            settings.divide = true;
+            break;
+        }
+        case 'c':
+        {
+            settings.check = true;
+            break;
+        }
+        case 'H':
+        {
+            settings.help = true;
+            break;
+        }
+        default:
+        {
+            throw Args::ArgsError{"invalid argument: " + arg};
+        }
+        }
+    }
+    return settings;
+}
+
+void printUsage(const std::string& progname)
+{
+    Settings settings;
+    std::cerr
+        << std::boolalpha << "Usage: " << progname
+        << " [-d<depth>] [-j<threads>] [-v] [-c] [-H] [<filename>...]"
+        << std::endl
+        << std::endl
+        << "    -d<depth>:    "
+           "Count up to the specified depth. Defaults to "
+        << settings.depth << "." << std::endl
+        << "    -j<threads>:  "
+           "Count with the specified number of threads. Defaults to "
+        << settings.threads << "." << std::endl
+        << "    -v:           "
+           "Print the count below each action at the last depth. Defaults to "
+        << settings.divide << "." << std::endl
+        << "    -c:           "
+           "Check the counts of BitboardGame against those of Game. "
+           "Defaults to "
+        << settings.check << "." << std::endl
+        << "    -H:           "
+           "Print usage information."
+        << std::endl
+        << "    <filename>:   "
+           "Count from the state in the given file as well as from the "
+           "initial state."
+        << std::endl;
+}
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        auto settings = parse(argc, argv);
+        if (settings.help)
+        {
+            printUsage(argv[0]);
+            return 0;
+        }
+
+        std::cout << "initial state" << std::endl;
+        bool isCorrect = run(settings, State{});
+        for (const auto& file : settings.files)
+        {
+            std::cout << file << std::endl;
+            isCorrect &= run(settings, Args::getState<Game>(file));
+        }
+        if (!isCorrect)
+        {
+            std::cout << "the move generation of BitboardGame is wrong"
+                      << std::endl;
+            return 4;
+        }
+        return 0;
+    }
+    catch (Args::ArgsError& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 2;
+    }
+    catch (...)
+    {
+        return 3;
+    }
+}
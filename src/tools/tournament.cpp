@@ -0,0 +1,726 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <functional>
+#include <exception>
+#include <stdexcept>
+
+#include "args.h"
+#include "game/game.h"
+#include "game/bitboard-game.h"
+#include "game/heuristics.h"
+#include "game/position.h"
+#include "search/iterative-alpha-beta.h"
+#include "search/mtdf.h"
+#include "search/limits.h"
+#include "search/options.h"
+
+using namespace DynamicConnect4;
+using namespace Search;
+
+using StateType = BitboardGame::StateType;
+using ActionType = BitboardGame::ActionType;
+using EvalType = BitboardGame::EvalType;
+using HeuristicType = std::function<EvalType(const StateType&)>;
+
+// This plays a tournament between two engines A and B without printing any
+// boards, to measure the difference of strength between them. The games are
+// played concurrently, each by a pair of single-threaded engines created for
+// it, so that no game depends on the ones before it. Each opening is played
+// twice, with A as player one and then as player two.
+//
+// After each game, the score of A is printed with its Elo difference and the
+// log-likelihood ratio of the sequential probability ratio test (SPRT), if
+// any, which stops the tournament once it accepts either hypothesis. The
+// games in progress at that moment are not counted, so the final score is
+// the one the SPRT decided on.
+
+namespace {
+
+// The number of plies after which a game is adjudicated a draw.
+const int maxPlies = 400;
+
+// The file the openings are loaded from by default, if it exists.
+const char* const defaultOpeningsFile = "test/openings.txt";
+
+// The probabilities of accepting the wrong hypothesis in the SPRT.
+const double sprtAlpha = 0.05;
+const double sprtBeta = 0.05;
+
+// An engine, described by comma-separated words:
+//      iab, mtdf
+//          The search engine, IterativeAlphaBeta or MTDf.
+//      cp<1-4>, cd<1-2>
+//          The versions of ConnectedPieces and CentralDominance to combine
+//          as the heuristic.
+//      futility, nolmr, nopvs, noaspiration, heuristicordering
+//          The search options that differ from the defaults.
+struct EngineSpec
+{
+    std::string name;
+    bool isMtdf{false};
+    int connectedPieces{1};
+    int centralDominance{2};
+    Options options;
+};
+
+struct Settings
+{
+    EngineSpec engineA;
+    EngineSpec engineB;
+    Limits limits;
+    int games{200};
+    int concurrency{1};
+    std::string openingsFile;
+    std::string recordsFile;
+    // The bounds of the SPRT in Elo, if any.
+    bool sprt{false};
+    double elo0{0};
+    double elo1{10};
+    bool help{false};
+};
+
+// A position to start games from, along with the line it was parsed from.
+struct Opening
+{
+    std::string line;
+    Position<BitboardGame> position;
+};
+
+// The result of a game, from the point of view of player one.
+struct GameRecord
+{
+    int result{0};
+    std::string reason;
+    std::vector<ActionType> actions;
+    double seconds{0};
+};
+
+// A player of the games, which hides the type of its search engine.
+class Player
+{
+public:
+    virtual ~Player() = default;
+
+    virtual ActionType search(
+        const StateType& state,
+        const std::vector<StateType>& history,
+        const Limits& limits) = 0;
+};
+
+template <typename Searcher>
+class SearchPlayer : public Player
+{
+public:
+    SearchPlayer(const EngineSpec& spec, HeuristicType heuristic)
+        : searcher{game, false, spec.options}, heuristic{heuristic}
+    {
+    }
+
+    virtual ActionType search(
+        const StateType& state,
+        const std::vector<StateType>& history,
+        const Limits& limits) override
+    {
+        searcher.setHistory(history);
+        return searcher.search(state, heuristic, limits, state.isPlayerOne);
+    }
+
+private:
+    BitboardGame game;
+    Searcher searcher;
+    HeuristicType heuristic;
+};
+
+EngineSpec parseEngine(const std::string& name)
+{
+    EngineSpec spec;
+    spec.name = name;
+    std::stringstream in{name};
+    std::string word;
+    while (std::getline(in, word, ','))
+    {
+        if (word == "iab")
+            spec.isMtdf = false;
+        else if (word == "mtdf")
+            spec.isMtdf = true;
+        else if (word.length() == 3 && word.compare(0, 2, "cp") == 0 &&
+                 word[2] >= '1' && word[2] <= '4')
+            spec.connectedPieces = word[2] - '0';
+        else if (word.length() == 3 && word.compare(0, 2, "cd") == 0 &&
+                 word[2] >= '1' && word[2] <= '2')
+            spec.centralDominance = word[2] - '0';
+        else if (word == "futility")
+            spec.options.futilityPruning = true;
+        else if (word == "nolmr")
+            spec.options.lateMoveReductions = false;
+        else if (word == "nopvs")
+            spec.options.principalVariation = false;
+        else if (word == "noaspiration")
+            spec.options.aspirationWindows = false;
+        else if (word == "heuristicordering")
+            spec.options.ordering = Ordering::heuristic;
+        else
+            throw Args::ArgsError{"invalid engine: " + name};
+    }
+    return spec;
+}
+
+template <typename ConnectedPieces>
+HeuristicType makeHeuristic(int centralDominance)
+{
+    if (centralDominance == 1)
+        return Heuristic<ConnectedPieces, CentralDominanceV1>{1.0f, 1.0f};
+    return Heuristic<ConnectedPieces, CentralDominanceV2>{1.0f, 1.0f};
+}
+
+HeuristicType makeHeuristic(const EngineSpec& spec)
+{
+    switch (spec.connectedPieces)
+    {
+    case 1:
+        return makeHeuristic<ConnectedPiecesV1>(spec.centralDominance);
+    case 2:
+        return makeHeuristic<ConnectedPiecesV2>(spec.centralDominance);
+    case 3:
+        return makeHeuristic<ConnectedPiecesV3>(spec.centralDominance);
+    default:
+        return makeHeuristic<ConnectedPiecesV4>(spec.centralDominance);
+    }
+}
+
+std::unique_ptr<Player> makePlayer(const EngineSpec& spec)
+{
+    if (spec.isMtdf)
+        return std::unique_ptr<Player>{
+            new SearchPlayer<MTDf<BitboardGame>>{spec, makeHeuristic(spec)}};
+    return std::unique_ptr<Player>{
+        new SearchPlayer<IterativeAlphaBeta<BitboardGame>>{
+            spec, makeHeuristic(spec)}};
+}
+
+GameRecord playGame(
+    const Position<BitboardGame>& opening,
+    const EngineSpec& playerOne,
+    const EngineSpec& playerTwo,
+    const Limits& limits)
+{
+    BitboardGame game;
+    auto playerOneEngine = makePlayer(playerOne);
+    auto playerTwoEngine = makePlayer(playerTwo);
+    auto state = opening.state;
+    auto history = opening.history;
+    GameRecord record;
+    auto t1 = std::chrono::steady_clock::now();
+    while (true)
+    {
+        if (game.isTerminal(state))
+        {
+            record.result = game.getUtility(state) ==
+                    std::numeric_limits<EvalType>::max() ?
+                1 :
+                -1;
+            record.reason = "win";
+            break;
+        }
+        if (game.isRepetition(state, history))
+        {
+            record.reason = "repetition";
+            break;
+        }
+        if (static_cast<int>(record.actions.size()) == maxPlies)
+        {
+            record.reason = "length";
+            break;
+        }
+
+        auto& player = state.isPlayerOne ? *playerOneEngine : *playerTwoEngine;
+        auto action = player.search(state, history, limits);
+        history.push_back(state);
+        game.makeMove(state, action);
+        record.actions.push_back(action);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    record.seconds = std::chrono::duration<double>(t2 - t1).count();
+    return record;
+}
+
+// Loads the openings from a file, or from the default one if none is given.
+// Without any, every game starts from the initial state, so engines limited
+// by nodes play the same two games over and over.
+std::vector<Opening> loadOpenings(const std::string& file)
+{
+    BitboardGame game;
+    std::vector<Opening> openings;
+    std::ifstream in{file.empty() ? defaultOpeningsFile : file};
+    if (!in && !file.empty())
+        throw std::runtime_error{"file not found: " + file};
+    if (!in)
+    {
+        std::cerr << "Warning: " << defaultOpeningsFile
+                  << " not found, so every game starts from the initial state"
+                  << std::endl;
+        openings.push_back(
+            Opening{"startpos", parsePosition(game, "startpos")});
+        return openings;
+    }
+
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+        openings.push_back(Opening{line, parsePosition(game, line)});
+    }
+    if (openings.empty())
+        throw std::runtime_error{
+            "no openings in " + (file.empty() ? defaultOpeningsFile : file)};
+    return openings;
+}
+
+// The score of engine A, from which its Elo difference with engine B and its
+// error are estimated with the normal approximation of the trinomial
+// distribution of the results of the games.
+struct Score
+{
+    int wins{0};
+    int draws{0};
+    int losses{0};
+
+    int getGames() const
+    {
+        return wins + draws + losses;
+    }
+
+    double getMean() const
+    {
+        return (wins + 0.5 * draws) / getGames();
+    }
+
+    double getVariance() const
+    {
+        auto mean = getMean();
+        return (wins * (1 - mean) * (1 - mean) +
+                draws * (0.5 - mean) * (0.5 - mean) +
+                losses * mean * mean) /
+            getGames();
+    }
+
+    // The Elo difference and the half-width of its 95% confidence interval.
+    double getElo() const
+    {
+        return toElo(getMean());
+    }
+
+    double getEloError() const
+    {
+        auto error = 1.96 * std::sqrt(getVariance() / getGames());
+        return (toElo(getMean() + error) - toElo(getMean() - error)) / 2;
+    }
+
+    // The log-likelihood ratio of the hypothesis that the Elo difference is
+    // elo1 against the hypothesis that it is elo0.
+    double getLogLikelihoodRatio(double elo0, double elo1) const
+    {
+        auto variance = getVariance();
+        if (variance == 0)
+            return 0;
+        auto score0 = toScore(elo0);
+        auto score1 = toScore(elo1);
+        return getGames() * (score1 - score0) *
+            (2 * getMean() - score0 - score1) / (2 * variance);
+    }
+
+    static double toElo(double score)
+    {
+        if (score <= 0)
+            return -std::numeric_limits<double>::infinity();
+        if (score >= 1)
+            return std::numeric_limits<double>::infinity();
+        return -400 * std::log10(1 / score - 1);
+    }
+
+    static double toScore(double elo)
+    {
+        return 1 / (1 + std::pow(10, -elo / 400));
+    }
+};
+
+// Prints an Elo difference, which is infinite when a score is 0 or 1, as
+// n/a in that case.
+void printElo(double elo)
+{
+    if (std::isfinite(elo))
+        std::cout << elo;
+    else
+        std::cout << "n/a";
+}
+
+void printScore(const Settings& settings, const Score& score)
+{
+    std::cout << "games " << score.getGames() << ": " << score.wins << " - "
+              << score.draws << " - " << score.losses << std::fixed
+              << std::setprecision(1) << ", elo ";
+    printElo(score.getElo());
+    std::cout << " +- ";
+    printElo(score.getEloError());
+    if (settings.sprt)
+        std::cout << std::setprecision(2) << ", llr "
+                  << score.getLogLikelihoodRatio(
+                         settings.elo0, settings.elo1)
+                  << " (" << std::log(sprtBeta / (1 - sprtAlpha)) << ", "
+                  << std::log((1 - sprtBeta) / sprtAlpha) << ")";
+    std::cout << std::defaultfloat << std::endl;
+}
+
+// Writes a record of a game on one line:
+//      <game> <opening> <player one> <player two> <result> <reason> <plies>
+//      <seconds> <position>
+// where <opening> is the index of the opening and <position> is its line
+// followed by the actions of the game, so that the last <plies> actions are
+// those of the game and the whole game can be replayed from the record.
+void writeRecord(
+    std::ostream& out,
+    int index,
+    int opening,
+    const std::string& openingLine,
+    const EngineSpec& playerOne,
+    const EngineSpec& playerTwo,
+    const GameRecord& record)
+{
+    out << index << " " << opening << " " << playerOne.name << " "
+        << playerTwo.name << " "
+        << (record.result > 0 ? "1-0" :
+                record.result < 0 ? "0-1" : "1/2-1/2")
+        << " " << record.reason << " " << record.actions.size() << " "
+        << std::fixed << std::setprecision(2) << record.seconds
+        << std::defaultfloat << " " << openingLine;
+    if (!record.actions.empty() &&
+        openingLine.find(" moves") == std::string::npos)
+        out << " moves";
+    for (const auto& action : record.actions)
+        out << " " << action;
+    out << std::endl;
+}
+
+void runTournament(const Settings& settings)
+{
+    auto openings = loadOpenings(settings.openingsFile);
+    std::ofstream records;
+    if (!settings.recordsFile.empty())
+    {
+        records.open(settings.recordsFile, std::ios::app);
+        if (!records)
+            throw std::runtime_error{"cannot open " + settings.recordsFile};
+    }
+
+    auto lowerBound = std::log(sprtBeta / (1 - sprtAlpha));
+    auto upperBound = std::log((1 - sprtBeta) / sprtAlpha);
+
+    // The mutex guards the games handed out, the score, the output and the
+    // error of the threads. Once the SPRT decides or a thread fails, no more
+    // games are handed out, and the games still being played are left out
+    // of the score, which stays as it was when the tournament ended.
+    std::mutex mutex;
+    Score score;
+    std::exception_ptr error;
+    int nextGame = 0;
+    bool isDone = false;
+    auto work = [&]() {
+        while (true)
+        {
+            int index;
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                if (isDone || nextGame >= settings.games)
+                    return;
+                index = nextGame++;
+            }
+            int opening = index / 2 % openings.size();
+            bool isAPlayerOne = index % 2 == 0;
+            const auto& playerOne =
+                isAPlayerOne ? settings.engineA : settings.engineB;
+            const auto& playerTwo =
+                isAPlayerOne ? settings.engineB : settings.engineA;
+
+            GameRecord record;
+            try
+            {
+                record = playGame(
+                    openings[opening].position,
+                    playerOne,
+                    playerTwo,
+                    settings.limits);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                error = std::current_exception();
+                isDone = true;
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock{mutex};
+            if (isDone)
+                return;
+            auto result = isAPlayerOne ? record.result : -record.result;
+            if (result > 0)
+                ++score.wins;
+            else if (result < 0)
+                ++score.losses;
+            else
+                ++score.draws;
+            if (records)
+                writeRecord(
+                    records,
+                    index,
+                    opening,
+                    openings[opening].line,
+                    playerOne,
+                    playerTwo,
+                    record);
+            printScore(settings, score);
+
+            auto ratio =
+                score.getLogLikelihoodRatio(settings.elo0, settings.elo1);
+            if (settings.sprt && (ratio <= lowerBound || ratio >= upperBound))
+                isDone = true;
+        }
+    };
+
+    std::cout << "A: " << settings.engineA.name << std::endl
+              << "B: " << settings.engineB.name << std::endl
+              << openings.size() << " openings, " << settings.concurrency
+              << " concurrent games" << std::endl;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < settings.concurrency; ++i)
+        threads.emplace_back(work);
+    for (auto& thread : threads)
+        thread.join();
+    if (error)
+        std::rethrow_exception(error);
+
+    std::cout << "final score of A: ";
+    printScore(settings, score);
+    if (settings.sprt)
+    {
+        auto ratio = score.getLogLikelihoodRatio(settings.elo0, settings.elo1);
+        std::cout << "sprt: "
+                  << (ratio >= upperBound ?
+                          "H1 accepted" :
+                          ratio <= lowerBound ? "H0 accepted" : "inconclusive")
+                  << std::endl;
+    }
+}
+
+Settings parse(int argc, char** argv)
+{
+    Settings settings;
+    settings.engineA = parseEngine("iab,cp1,cd2");
+    settings.engineB = parseEngine("iab,cp4,cd2");
+    settings.concurrency =
+        std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    int hashSizeInMb = 16;
+    bool hasLimit = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg{argv[i]};
+        if (arg.length() < 2 || arg[0] != '-')
+            throw Args::ArgsError{"invalid argument: " + arg};
+        switch (arg[1])
+        {
+        case 'a':
+        {
+            settings.engineA = parseEngine(arg.substr(2));
+            break;
+        }
+        case 'b':
+        {
+            settings.engineB = parseEngine(arg.substr(2));
+            break;
+        }
+        case 'n':
+        {
+            settings.limits.nodes = Args::parseNumber<long long>(arg);
+            if (settings.limits.nodes < 1)
+                throw Args::ArgsError{"invalid argument: " + arg};
+            hasLimit = true;
+            break;
+        }
+        case 't':
+        {
+            settings.limits.timeLimitInMs = Args::parseNumber<int>(arg);
+            settings.limits.targetTimeInMs = settings.limits.timeLimitInMs;
+            if (settings.limits.timeLimitInMs < 0)
+                throw Args::ArgsError{"invalid argument: " + arg};
+            hasLimit = true;
+            break;
+        }
+        case 'g':
+        {
+            settings.games = Args::parseNumber<int>(arg);
+            if (settings.games < 1)
+                throw Args::ArgsError{"invalid argument: " + arg};
+            break;
+        }
+        case 'c':
+        {
+            settings.concurrency = Args::parseNumber<int>(arg);
+            if (settings.concurrency < 1)
+                throw Args::ArgsError{"invalid argument: " + arg};
+            break;
+        }
+        case 'm':
+        {
+            hashSizeInMb = Args::parseNumber<int>(arg);
+            if (hashSizeInMb < 1)
+                throw Args::ArgsError{"invalid argument: " + arg};
+            break;
+        }
+        case 'o':
+        {
+            settings.openingsFile = arg.substr(2);
+            break;
+        }
+        case 'r':
+        {
+            settings.recordsFile = arg.substr(2);
+            break;
+        }
+        case 's':
+        {
+            std::stringstream ss{arg.substr(2)};
+            char colon;
+            ss >> settings.elo0 >> colon >> settings.elo1;
+            if (!ss || colon != ':' || !ss.eof() ||
+                settings.elo0 >= settings.elo1)
+                throw Args::ArgsError{"invalid argument: " + arg};
+            settings.sprt = true;
+            break;
+        }
+        case 'H':
+        {
+            settings.help = true;
+            break;
+        }
+        default:
+        {
+            throw Args::ArgsError{"invalid argument: " + arg};
+        }
+        }
+    }
+
+    if (!hasLimit)
+        settings.limits.nodes = 50000;
+    settings.engineA.options.hashSizeInMb = hashSizeInMb;
+    settings.engineB.options.hashSizeInMb = hashSizeInMb;
+    return settings;
+}
+
+void printUsage(const std::string& progname)
+{
+    Settings settings;
+    std::cerr
+        << "Usage: " << progname
+        << " [-a<engine>] [-b<engine>] [-n<nodes>] [-t<ms>] [-g<games>]"
+        << " [-c<games>] [-m<MB>]" << std::endl
+        << "       " << std::string(progname.length(), ' ')
+        << " [-o<filename>] [-r<filename>] [-s<e0>:<e1>] [-H]"
+        << std::endl
+        << std::endl
+        << "    -a<engine>:     "
+           "Specifies engine A. Defaults to iab,cp1,cd2."
+        << std::endl
+        << "    -b<engine>:     "
+           "Specifies engine B. Defaults to iab,cp4,cd2."
+        << std::endl
+        << "                    "
+           "<engine> is a comma-separated list of iab or mtdf, cp<1-4>, "
+           "cd<1-2>,"
+        << std::endl
+        << "                    "
+           "futility, nolmr, nopvs, noaspiration and heuristicordering."
+        << std::endl
+        << "    -n<nodes>:      "
+           "Search the specified number of nodes per move. Defaults to "
+           "50000 nodes"
+        << std::endl
+        << "                    "
+           "when there is no time limit."
+        << std::endl
+        << "    -t<ms>:         "
+           "Search for the specified time in ms per move."
+        << std::endl
+        << "    -g<games>:      "
+           "Play at most the specified number of games. Defaults to "
+        << settings.games << "." << std::endl
+        << "    -c<games>:      "
+           "Play the specified number of games at once. Defaults to the "
+           "number of cores."
+        << std::endl
+        << "    -m<MB>:         "
+           "Limit the transposition table of each engine to the specified "
+           "size in MB."
+        << std::endl
+        << "                    "
+           "Defaults to 16 MB."
+        << std::endl
+        << "    -o<filename>:   "
+           "Load the openings from the given file, with one position per "
+           "line, given as"
+        << std::endl
+        << "                    "
+           "(startpos | state <1|2> <rows>) [moves <action>...]. Defaults to "
+        << std::endl
+        << "                    "
+        << defaultOpeningsFile << ", or to startpos if it is not found."
+        << std::endl
+        << "    -r<filename>:   "
+           "Append a record of each game to the given file."
+        << std::endl
+        << "    -s<e0>:<e1>:    "
+           "Stop once the SPRT of A having e0 Elo more than B against e1 "
+           "accepts either."
+        << std::endl
+        << "    -H:             "
+           "Print usage information."
+        << std::endl;
+}
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        auto settings = parse(argc, argv);
+        if (settings.help)
+            printUsage(argv[0]);
+        else
+            runTournament(settings);
+        return 0;
+    }
+    catch (Args::ArgsError& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 2;
+    }
+    catch (...)
+    {
+        return 3;
+    }
+}
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include <limits>
+#include <mutex>
+#include <future>
+
+#include "game/game.h"
+#include "game/bitboard-game.h"
+#include "game/heuristics.h"
+#include "game/position.h"
+#include "search/iterative-alpha-beta.h"
+#include "search/engine.h"
+#include "search/limits.h"
+
+using namespace DynamicConnect4;
+using namespace Search;
+
+// This implements an engine protocol in the style of UCI through standard
+// input and output, so that a match runner can drive the agent without
+// parsing its boards. The commands are:
+//      uci, isready, ucinewgame, quit
+//          As in UCI.
+//      position (startpos | state <player> <rows>) [moves <action>...]
+//          Sets the position to search, either the initial one or the one
+//          whose board rows are given as in the state files, separated by
+//          '/', with <player> = 1 or 2 to move, followed by the given actions.
+//      go [ponder] [movetime <ms>] [depth <plies>] [nodes <count>]
+//      [infinite]
+//          Searches the position within the given limits, or until stopped.
+//          When pondering, the limits only apply from the next ponderhit.
+//      ponderhit, stop
+//          As in UCI.
+// The agent replies to go with info lines after each iteration, giving the
+// depth, the nodes and nodes per second of the search, the score for the
+// player to move, which is win or loss once it is decided, and the principal
+// variation, and then with the bestmove line. Debug information is printed
+// using std::cerr.
+class UciClient
+{
+public:
+    UciClient(const Options& options = Options{}, bool debug = false)
+        : engine{game, heuristic, debug, options}
+    {
+        engine.setListener(
+            [this](const IterativeAlphaBeta<BitboardGame>::Progress& progress) {
+                printInfo(progress);
+            });
+    }
+
+    void run()
+    {
+        std::string line;
+        while (std::getline(std::cin, line))
+        {
+            std::stringstream in{line};
+            std::string command;
+            in >> command;
+            if (command == "uci")
+            {
+                print("id name dynamic-connect-4");
+                print("uciok");
+            }
+            else if (command == "isready")
+                print("readyok");
+            else if (command == "ucinewgame")
+            {
+                stop();
+                state = StateType{};
+                history.clear();
+            }
+            else if (command == "position")
+                position(in);
+            else if (command == "go")
+                go(in);
+            else if (command == "ponderhit")
+                ponderHit();
+            else if (command == "stop")
+                stop();
+            else if (command == "quit")
+                break;
+            else if (!command.empty())
+                print("info string unknown command: " + command);
+        }
+        stop();
+    }
+
+private:
+    using StateType = BitboardGame::StateType;
+    using ActionType = BitboardGame::ActionType;
+    using EvalType = BitboardGame::EvalType;
+    using Clock = std::chrono::steady_clock;
+
+    BitboardGame game;
+    Heuristic<ConnectedPiecesV1, CentralDominanceV2> heuristic{1.0f, 1.0f};
+    Engine<IterativeAlphaBeta<BitboardGame>> engine;
+    StateType state;
+    // The positions of the game before the current one.
+    std::vector<StateType> history;
+
+    // The mutex guards the output, and the state of the search, whose result
+    // is held back until ponderhit or stop while it ponders.
+    std::mutex mutex;
+    bool isPondering{false};
+    bool hasResult{false};
+    ActionType result;
+    Limits ponderLimits;
+    Clock::time_point startTime;
+
+    void position(std::stringstream& in)
+    {
+        std::string text;
+        std::getline(in >> std::ws, text);
+        try
+        {
+            auto position = parsePosition(game, text);
+            stop();
+            state = position.state;
+            history = position.history;
+        }
+        catch (std::runtime_error& e)
+        {
+            print(std::string{"info string "} + e.what());
+        }
+    }
+
+    void go(std::stringstream& in)
+    {
+        stop();
+        if (game.isTerminal(state))
+        {
+            print("info string the game is over");
+            return;
+        }
+
+        Limits limits;
+        bool ponder = false;
+        bool isValid = true;
+        std::string token;
+        while (isValid && in >> token)
+        {
+            if (token == "ponder")
+                ponder = true;
+            else if (token == "movetime")
+            {
+                isValid = static_cast<bool>(in >> limits.timeLimitInMs);
+                limits.targetTimeInMs = limits.timeLimitInMs;
+            }
+            else if (token == "depth")
+                isValid = static_cast<bool>(in >> limits.depth);
+            else if (token == "nodes")
+                isValid = static_cast<bool>(in >> limits.nodes);
+            else if (token != "infinite")
+                isValid = false;
+        }
+        if (!isValid)
+        {
+            print("info string invalid limits");
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            isPondering = ponder;
+            hasResult = false;
+            ponderLimits = limits;
+            startTime = Clock::now();
+        }
+        engine.setHistory(history);
+        engine.start(
+            state,
+            state.isPlayerOne,
+            ponder ? Limits{} : limits,
+            [this](const ActionType& action) { finish(action); });
+    }
+
+    void ponderHit()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (!isPondering)
+            return;
+        isPondering = false;
+        // If the search is over, its result was held back, and otherwise, it
+        // goes on within the limits of the go command.
+        if (hasResult)
+            printResult();
+        else
+            engine.ponderHit(ponderLimits);
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            isPondering = false;
+            if (hasResult)
+                printResult();
+        }
+        engine.stop();
+    }
+
+    // Called once the search returns.
+    void finish(const ActionType& action)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        result = action;
+        hasResult = true;
+        if (!isPondering)
+            printResult();
+    }
+
+    void printResult()
+    {
+        hasResult = false;
+        std::stringstream out;
+        out << "bestmove " << result;
+        auto variation = engine.getPrincipalVariation();
+        if (variation.size() >= 2 && variation[0] == result)
+            out << " ponder " << variation[1];
+        std::cout << out.str() << std::endl;
+    }
+
+    void printInfo(const IterativeAlphaBeta<BitboardGame>::Progress& progress)
+    {
+        // The table may still hold the actions of deeper searches beyond the
+        // depth of this iteration, which are not part of its variation.
+        auto variation = engine.getPrincipalVariation();
+        if (static_cast<int>(variation.size()) > progress.depth)
+            variation.resize(progress.depth);
+        std::lock_guard<std::mutex> lock{mutex};
+        auto seconds =
+            std::chrono::duration<double>(Clock::now() - startTime).count();
+        std::stringstream out;
+        out << "info depth " << progress.depth << " nodes " << progress.count
+            << " nps "
+            << static_cast<long long>(progress.count / std::max(seconds, 1e-6))
+            << " score ";
+        auto value =
+            state.isPlayerOne ? progress.value : EvalType{} - progress.value;
+        if (value == std::numeric_limits<EvalType>::max())
+            out << "win";
+        else if (value == std::numeric_limits<EvalType>::lowest())
+            out << "loss";
+        else
+            out << value;
+        out << " pv";
+        for (const auto& action : variation)
+            out << " " << action;
+        std::cout << out.str() << std::endl;
+    }
+
+    void print(const std::string& line)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        std::cout << line << std::endl;
+    }
+};
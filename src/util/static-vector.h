@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <utility>
+#include <cstddef>
+
+namespace Util {
+
+// A vector with a fixed capacity that stores its elements inline, so it never
+// allocates. It is meant for short lists built in the innermost loops of the
+// search, where the heap allocations of std::vector are a significant cost.
+// Growing the vector past its capacity is undefined behaviour.
+template <typename T, size_t N>
+class StaticVector
+{
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    static constexpr size_type capacity()
+    {
+        return N;
+    }
+
+    iterator begin()
+    {
+        return elements.data();
+    }
+
+    const_iterator begin() const
+    {
+        return elements.data();
+    }
+
+    iterator end()
+    {
+        return elements.data() + count;
+    }
+
+    const_iterator end() const
+    {
+        return elements.data() + count;
+    }
+
+    size_type size() const
+    {
+        return count;
+    }
+
+    bool empty() const
+    {
+        return count == 0;
+    }
+
+    reference operator[](size_type index)
+    {
+        return elements[index];
+    }
+
+    const_reference operator[](size_type index) const
+    {
+        return elements[index];
+    }
+
+    reference front()
+    {
+        return elements[0];
+    }
+
+    const_reference front() const
+    {
+        return elements[0];
+    }
+
+    reference back()
+    {
+        return elements[count - 1];
+    }
+
+    const_reference back() const
+    {
+        return elements[count - 1];
+    }
+
+    void push_back(const T& value)
+    {
+        elements[count++] = value;
+    }
+
+    template <typename... Args>
+    void emplace_back(Args&&... args)
+    {
+        elements[count++] = T(std::forward<Args>(args)...);
+    }
+
+    void pop_back()
+    {
+        --count;
+    }
+
+    void resize(size_type size)
+    {
+        for (; count < size; ++count)
+            elements[count] = T{};
+        count = size;
+    }
+
+    void clear()
+    {
+        count = 0;
+    }
+
+private:
+    std::array<T, N> elements;
+    size_type count{0};
+};
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <streambuf>
+#include <algorithm>
+
+namespace Util {
+
+// A stream buffer that writes everything to two other stream buffers, such as
+// those of std::cerr and of a log file.
+class TeeBuffer : public std::streambuf
+{
+public:
+    TeeBuffer(std::streambuf* first, std::streambuf* second)
+        : first{first}, second{second}
+    {
+    }
+
+protected:
+    virtual int_type overflow(int_type ch) override
+    {
+        if (traits_type::eq_int_type(ch, traits_type::eof()))
+            return traits_type::not_eof(ch);
+        auto c = traits_type::to_char_type(ch);
+        if (traits_type::eq_int_type(first->sputc(c), traits_type::eof()) ||
+            traits_type::eq_int_type(second->sputc(c), traits_type::eof()))
+            return traits_type::eof();
+        return ch;
+    }
+
+    virtual std::streamsize xsputn(const char* s, std::streamsize n) override
+    {
+        auto count = first->sputn(s, n);
+        return std::min(count, second->sputn(s, n));
+    }
+
+    virtual int sync() override
+    {
+        auto result = first->pubsync();
+        return second->pubsync() == 0 ? result : -1;
+    }
+
+private:
+    std::streambuf* first;
+    std::streambuf* second;
+};
+}
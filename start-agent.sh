@@ -14,8 +14,8 @@ fi
 
 server="$1"
 port="$2"
-if ! echo q | telnet -eq "$server" "$port"; then
-    echo "Error: server not found"
+if ! [[ "$port" =~ ^[0-9]+$ ]]; then
+    echo "Error: invalid port"
     printUsage
     exit 2
 fi
@@ -34,14 +34,7 @@ if [[ "$player" != "1" && "$player" != "2" ]]; then
     exit 4
 fi
 
-pipe="pipe$player"
 logfile="logs/$gameId.$player.`date +%Y-%m-%dT%H:%M:%S%z`.log"
 
 mkdir -p logs
-rm -f --interactive=never "$pipe"
-if mkfifo "$pipe"; then
-    (./agent.exe -n -i"$gameId" -p"$player" -t19500 <"$pipe" \
-        | tee >(telnet "$server" "$port" >"$pipe"))          \
-        &> >(tee -a "$logfile")
-    rm --interactive=never "$pipe"
-fi
+./agent.exe -s"$server:$port" -i"$gameId" -p"$player" -t19500 -l"$logfile"